@@ -0,0 +1,255 @@
+/*
+  ==============================================================================
+
+    AudioThreadAudit.cpp
+    Created: 19 Oct 2026
+
+    Debug facility that catches allocations and locks on the audio thread.
+
+  ==============================================================================
+*/
+
+#include "AudioThreadAudit.h"
+
+#if NORDICSMC_AUDIT_AUDIO_THREAD
+
+#include <new>
+#include <cstdlib>
+
+#if defined (__GLIBC__)
+ #include <pthread.h>
+ #include <dlfcn.h>
+#endif
+
+/*
+ With glibc, malloc() itself is replaced (see the end of this file), so the replacements of operator new call the internal
+ functions of glibc directly; otherwise an allocation with new would be reported twice.
+ 
+ The thread-local variables use the initial-exec model there: the default model for a shared library (the plugin) may call malloc()
+ on the first access from a thread, which would call the replaced malloc() again.
+ */
+#if defined (__GLIBC__)
+ extern "C"
+ {
+     void* __libc_malloc (size_t);
+     void* __libc_calloc (size_t, size_t);
+     void* __libc_realloc (void*, size_t);
+     void __libc_free (void*);
+ }
+ 
+ #define NORDICSMC_AUDIT_HOOKS_MALLOC 1
+ #define NORDICSMC_AUDIT_THREAD_LOCAL thread_local __attribute__ ((tls_model ("initial-exec")))
+#else
+ #define NORDICSMC_AUDIT_HOOKS_MALLOC 0
+ #define NORDICSMC_AUDIT_THREAD_LOCAL thread_local
+#endif
+
+namespace AudioThreadAudit
+{
+    namespace
+    {
+        NORDICSMC_AUDIT_THREAD_LOCAL int audioThreadDepth = 0;  // > 0 while inside a ScopedAudioThread
+        NORDICSMC_AUDIT_THREAD_LOCAL bool reporting = false;    // true while a violation is being reported (the report allocates)
+        std::atomic<int> numViolations { 0 };
+    }
+    
+    ScopedAudioThread::ScopedAudioThread() { ++audioThreadDepth; }
+    ScopedAudioThread::~ScopedAudioThread() { --audioThreadDepth; }
+    
+    bool isAudioThread() noexcept
+    {
+        return audioThreadDepth > 0 && ! reporting;
+    }
+    
+    void reportViolation (const char* what)
+    {
+        reporting = true;
+        numViolations.fetch_add (1, std::memory_order_relaxed);
+        
+        Logger::writeToLog ("Audio thread violation (" + String (what) + ") in processBlock():\n" + SystemStats::getStackBacktrace());
+        
+       #if NORDICSMC_AUDIT_ABORT
+        std::abort();
+       #endif
+        
+        // Not real-time safe: see the stack trace in the log
+        jassertfalse;
+        reporting = false;
+    }
+    
+    int getNumViolations() noexcept
+    {
+        return numViolations.load (std::memory_order_relaxed);
+    }
+    
+    namespace
+    {
+        // Allocation without the audit (the replacements below are built on these)
+        void* allocate (std::size_t size)
+        {
+           #if NORDICSMC_AUDIT_HOOKS_MALLOC
+            return __libc_malloc (size);
+           #else
+            return std::malloc (size);
+           #endif
+        }
+        
+        void deallocate (void* ptr)
+        {
+           #if NORDICSMC_AUDIT_HOOKS_MALLOC
+            __libc_free (ptr);
+           #else
+            std::free (ptr);
+           #endif
+        }
+    }
+}
+
+//==============================================================================
+/*
+ Replacements of the global operator new / delete. They behave like the default ones (malloc / free),
+ but report a violation when they're called on the audio thread.
+ */
+void* operator new (std::size_t size)
+{
+    if (AudioThreadAudit::isAudioThread())
+        AudioThreadAudit::reportViolation ("operator new");
+    
+    if (void* ptr = AudioThreadAudit::allocate (size != 0 ? size : 1))
+        return ptr;
+    
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    if (AudioThreadAudit::isAudioThread())
+        AudioThreadAudit::reportViolation ("operator new");
+    
+    return AudioThreadAudit::allocate (size != 0 ? size : 1);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t& nothrow) noexcept
+{
+    return operator new (size, nothrow);
+}
+
+void operator delete (void* ptr) noexcept
+{
+    if (ptr != nullptr && AudioThreadAudit::isAudioThread())
+        AudioThreadAudit::reportViolation ("operator delete");
+    
+    AudioThreadAudit::deallocate (ptr);
+}
+
+void operator delete[] (void* ptr) noexcept                        { operator delete (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept             { operator delete (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept           { operator delete (ptr); }
+void operator delete (void* ptr, const std::nothrow_t&) noexcept   { operator delete (ptr); }
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept { operator delete (ptr); }
+
+//==============================================================================
+#if NORDICSMC_AUDIT_HOOKS_MALLOC
+/*
+ Replacements of the C allocation functions (glibc only). These catch the allocations that don't go through operator new,
+ e.g. juce::HeapBlock and C libraries.
+ */
+extern "C"
+{
+    void* malloc (size_t size) noexcept
+    {
+        if (AudioThreadAudit::isAudioThread())
+            AudioThreadAudit::reportViolation ("malloc");
+        
+        return __libc_malloc (size);
+    }
+    
+    void* calloc (size_t numElements, size_t size) noexcept
+    {
+        if (AudioThreadAudit::isAudioThread())
+            AudioThreadAudit::reportViolation ("calloc");
+        
+        return __libc_calloc (numElements, size);
+    }
+    
+    void* realloc (void* ptr, size_t size) noexcept
+    {
+        if (AudioThreadAudit::isAudioThread())
+            AudioThreadAudit::reportViolation ("realloc");
+        
+        return __libc_realloc (ptr, size);
+    }
+    
+    void free (void* ptr) noexcept
+    {
+        if (ptr != nullptr && AudioThreadAudit::isAudioThread())
+            AudioThreadAudit::reportViolation ("free");
+        
+        __libc_free (ptr);
+    }
+}
+
+/*
+ Replacements of the blocking pthread locks (glibc only). These catch the locks that don't go through AudioThreadAudit::Mutex,
+ e.g. juce::CriticalSection, std::mutex and std::shared_timed_mutex. The try- versions don't block, so they aren't audited.
+ 
+ Unlike malloc(), glibc doesn't export linkable internal versions of these, so the replacements forward to the next definition
+ (the one of glibc) found with dlsym (RTLD_NEXT). It is looked up on the first call and kept in an atomic rather than a
+ function-local static, as the guard of a static may itself lock.
+ */
+namespace AudioThreadAudit
+{
+    namespace
+    {
+        template <typename Function>
+        Function* findNextDefinition (std::atomic<Function*>& next, const char* name)
+        {
+            Function* function = next.load (std::memory_order_relaxed);
+            if (function == nullptr)
+            {
+                function = reinterpret_cast<Function*> (dlsym (RTLD_NEXT, name));
+                next.store (function, std::memory_order_relaxed);
+            }
+            return function;
+        }
+        
+        std::atomic<int (*) (pthread_mutex_t*)> nextMutexLock { nullptr };
+        std::atomic<int (*) (pthread_rwlock_t*)> nextReadLock { nullptr };
+        std::atomic<int (*) (pthread_rwlock_t*)> nextWriteLock { nullptr };
+    }
+}
+
+extern "C"
+{
+    int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+    {
+        if (AudioThreadAudit::isAudioThread())
+            AudioThreadAudit::reportViolation ("pthread_mutex_lock");
+        
+        return AudioThreadAudit::findNextDefinition (AudioThreadAudit::nextMutexLock, "pthread_mutex_lock") (mutex);
+    }
+    
+    int pthread_rwlock_rdlock (pthread_rwlock_t* rwlock) noexcept
+    {
+        if (AudioThreadAudit::isAudioThread())
+            AudioThreadAudit::reportViolation ("pthread_rwlock_rdlock");
+        
+        return AudioThreadAudit::findNextDefinition (AudioThreadAudit::nextReadLock, "pthread_rwlock_rdlock") (rwlock);
+    }
+    
+    int pthread_rwlock_wrlock (pthread_rwlock_t* rwlock) noexcept
+    {
+        if (AudioThreadAudit::isAudioThread())
+            AudioThreadAudit::reportViolation ("pthread_rwlock_wrlock");
+        
+        return AudioThreadAudit::findNextDefinition (AudioThreadAudit::nextWriteLock, "pthread_rwlock_wrlock") (rwlock);
+    }
+}
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    AudioThreadAudit.h
+    Created: 19 Oct 2026
+
+    Debug facility that catches allocations and locks on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/* Audio thread audit (selected at compile time)
+ 
+        0: off (default). ScopedAudioThread does nothing and AudioThreadAudit::Mutex is a plain CriticalSection.
+        1: on. processBlock() marks its thread as the audio thread for the duration of the call, and on that thread
+           - every global operator new / delete (including the ones made by std::vector, String, etc.),
+           - with glibc (Linux): every malloc(), calloc(), realloc() and free() (including juce::HeapBlock),
+           - every blocking lock of an AudioThreadAudit::Mutex (e.g. the one of the PresetBank) and
+           - with glibc: every pthread_mutex_lock(), pthread_rwlock_rdlock() and pthread_rwlock_wrlock() (including juce::CriticalSection
+             and std::mutex)
+           is a violation: it is written to the log with a stack trace, counted (getNumViolations()) and hits a jassert.
+           With NORDICSMC_AUDIT_ABORT set to 1 the process aborts instead, so that automated runs fail at the first violation.
+ 
+        Only use this in debug builds: replacing the global operator new affects the whole process on some platforms (the host included).
+        Other C libraries than glibc can't be hooked portably from inside a plugin, so malloc() and the OS-level locks aren't audited there.
+        Spin locks (juce::SpinLock, std::atomic_flag) never call into the C library, so they aren't audited on any platform, and neither are
+        over-aligned allocations (aligned_alloc(), posix_memalign()) and allocations inside the C library itself.
+        The unit tests (Tests/Source/AudioThreadAuditTests.cpp) are built with the audit on and run processBlock() in all the modes.
+ */
+#ifndef NORDICSMC_AUDIT_AUDIO_THREAD
+ #define NORDICSMC_AUDIT_AUDIO_THREAD 0
+#endif
+
+#ifndef NORDICSMC_AUDIT_ABORT
+ #define NORDICSMC_AUDIT_ABORT 0
+#endif
+
+namespace AudioThreadAudit
+{
+   #if NORDICSMC_AUDIT_AUDIO_THREAD
+    // Marks the current thread as the audio thread while it exists (can be nested)
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread();
+        ~ScopedAudioThread();
+        
+        JUCE_DECLARE_NON_COPYABLE (ScopedAudioThread)
+    };
+    
+    // Whether the current thread is (currently) marked as the audio thread
+    bool isAudioThread() noexcept;
+    
+    // Logs (with a stack trace) and counts a violation. Allocations made by the report itself are not audited.
+    void reportViolation (const char* what);
+    
+    // Number of violations so far (safe to read from any thread)
+    int getNumViolations() noexcept;
+   #else
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread() {}
+    };
+    
+    inline bool isAudioThread() noexcept { return false; }
+    inline int getNumViolations() noexcept { return 0; }
+   #endif
+    
+    /* Lock for data shared with the audio thread. Blocking on it (enter()) from the audio thread is a violation;
+       tryEnter() never blocks, so it is allowed. Use it like a CriticalSection:
+ 
+            const AudioThreadAudit::Mutex::ScopedLockType lock (mutex);
+     */
+    class Mutex
+    {
+    public:
+        Mutex() = default;
+        
+        void enter() const noexcept
+        {
+           #if NORDICSMC_AUDIT_AUDIO_THREAD && ! defined (__GLIBC__)
+            // (With glibc, the replaced pthread_mutex_lock() of the CriticalSection reports it)
+            if (isAudioThread())
+                reportViolation ("lock");
+           #endif
+            lock.enter();
+        }
+        
+        bool tryEnter() const noexcept { return lock.tryEnter(); }
+        void exit() const noexcept { lock.exit(); }
+        
+        using ScopedLockType = GenericScopedLock<Mutex>;
+        
+    private:
+        CriticalSection lock;
+        
+        JUCE_DECLARE_NON_COPYABLE (Mutex)
+    };
+}
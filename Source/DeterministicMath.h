@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    DeterministicMath.h
+    Created: 19 Oct 2026
+
+    Portable replacements for sin() and exp() that give identical results on every platform.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if defined (__FAST_MATH__)
+ #warning "DeterministicMath relies on strict IEEE 754 arithmetic and is not bit-exact with -ffast-math"
+#endif
+
+/*
+    The results of libm functions such as sin() and exp() can differ in the last bit between compilers, C libraries and CPUs.
+    The functions below only use +, -, *, floor() and ldexp(), which are exact or correctly rounded in IEEE 754, in a fixed order.
+    As long as the compiler doesn't contract a * b + c into a fused multiply-add or reorder operations (no -ffast-math),
+    they give the same result on every x86-64 and ARM build.
+
+    Builds that are covered (the reference checksums in Tests/Source/BitExactTests.cpp check this):
+        - Xcode (clang, x86-64 and arm64): -ffp-contract=off (see the .jucer files). Without it, clang contracts on arm64.
+        - Visual Studio 2019: /fp:precise at the default /arch (SSE2 on x64), which never emits FMA instructions.
+          VS2019 has no /fp:contract- switch and may contract with /arch:AVX2 (or /arch:AVX512), so don't use those
+          (VS2022 only contracts with /fp:contract).
+        - Other builds (e.g. GCC on Linux) need -ffp-contract=off as well; GCC contracts by default when FMA is available (-march=native).
+*/
+namespace DeterministicMath
+{
+    // sin (x) for |x| up to a few times 2 pi (the accuracy degrades for large arguments). Error below 1e-15.
+    inline double sin (double x)
+    {
+        const double twoPi = 6.283185307179586;
+        const double pi = 3.141592653589793;
+        const double halfPi = 1.5707963267948966;
+
+        // Reduce to [-pi, pi] and then to [-pi / 2, pi / 2] using sin (pi - x) = sin (x)
+        x -= twoPi * std::floor (x / twoPi + 0.5);
+        if (x > halfPi)
+            x = pi - x;
+        else if (x < -halfPi)
+            x = -pi - x;
+
+        // Taylor series up to x^21 in Horner form (the remainder is below (pi / 2)^23 / 23! = 4e-18)
+        const double x2 = x * x;
+        double result = 1.0 / 51090942171709440000.0;       // 1 / 21!
+        result = result * -x2 + 1.0 / 121645100408832000.0; // 1 / 19!
+        result = result * -x2 + 1.0 / 355687428096000.0;    // 1 / 17!
+        result = result * -x2 + 1.0 / 1307674368000.0;      // 1 / 15!
+        result = result * -x2 + 1.0 / 6227020800.0;         // 1 / 13!
+        result = result * -x2 + 1.0 / 39916800.0;           // 1 / 11!
+        result = result * -x2 + 1.0 / 362880.0;             // 1 / 9!
+        result = result * -x2 + 1.0 / 5040.0;               // 1 / 7!
+        result = result * -x2 + 1.0 / 120.0;               // 1 / 5!
+        result = result * -x2 + 1.0 / 6.0;                 // 1 / 3!
+        result = result * -x2 + 1.0;
+        return result * x;
+    }
+
+    // exp (x) for x between -700 and 700. Relative error below 1e-14.
+    inline double exp (double x)
+    {
+        const double ln2 = 0.6931471805599453;
+        x = jlimit (-700.0, 700.0, x);
+
+        // exp (x) = 2^k * exp (r) with |r| <= ln(2) / 2
+        const double k = std::floor (x / ln2 + 0.5);
+        const double r = x - k * ln2;
+
+        // Taylor series up to r^16 in Horner form (the remainder is below 0.35^17 / 17! = 5e-23)
+        double result = 1.0;
+        for (int n = 16; n >= 1; --n)
+            result = 1.0 + result * r / n;
+
+        return std::ldexp (result, static_cast<int> (k));
+    }
+}
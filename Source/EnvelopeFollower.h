@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    EnvelopeFollower.h
+    Created: 19 Oct 2026
+
+    Envelope follower used to modulate the flanger from the sidechain input.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DeterministicMath.h"
+
+//==============================================================================
+/**
+    Peak or RMS envelope follower with separate attack and release times.
+
+    A block is processed in three passes so that only the recursive smoothing is done sample by sample:
+        1. detector (vectorisable): |x| (peak) or x^2 (RMS), taking the maximum / mean over the channels
+        2. smoothing (branch-free): a one-pole filter whose coefficient is selected with a ternary, which compiles to a select rather than a jump
+        3. RMS only (vectorisable): square root of the smoothed mean square
+*/
+class EnvelopeFollower
+{
+public:
+    enum class Mode
+    {
+        peak,
+        rms
+    };
+
+    EnvelopeFollower() { prepare (fs); };
+
+    void prepare (double sampleRate)
+    {
+        fs = sampleRate;
+        setAttack (attackMs);
+        setRelease (releaseMs);
+        reset();
+    }
+
+    void reset() { state = 0.0f; };
+
+    // Attack and release times in milliseconds (the time it takes to reach 1 - 1/e of a step)
+    void setAttack (double attackToSet) { attackMs = attackToSet; attackCoeff = calculateCoefficient (attackMs); };
+    void setRelease (double releaseToSet) { releaseMs = releaseToSet; releaseCoeff = calculateCoefficient (releaseMs); };
+    void setMode (Mode modeToSet) { mode = modeToSet; };
+    double getAttack() const { return attackMs; };
+    double getRelease() const { return releaseMs; };
+    Mode getMode() const { return mode; };
+
+    // Writes the envelope of the given channels (numSamples each) to "envelope"
+    void process (const float* const* channels, int numChannels, float* envelope, int numSamples)
+    {
+        // 1. detector
+        const float channelScaling = 1.0f / static_cast<float> (numChannels);
+        for (int i = 0; i < numSamples; ++i)
+            envelope[i] = mode == Mode::peak ? std::abs (channels[0][i]) : channels[0][i] * channels[0][i] * channelScaling;
+
+        for (int channel = 1; channel < numChannels; ++channel)
+        {
+            if (mode == Mode::peak)
+                for (int i = 0; i < numSamples; ++i)
+                    envelope[i] = jmax (envelope[i], std::abs (channels[channel][i]));
+            else
+                for (int i = 0; i < numSamples; ++i)
+                    envelope[i] += channels[channel][i] * channels[channel][i] * channelScaling;
+        }
+
+        // 2. smoothing
+        float env = state;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float coeff = envelope[i] > env ? attackCoeff : releaseCoeff;
+            env = envelope[i] + coeff * (env - envelope[i]);
+            envelope[i] = env;
+        }
+        state = env;
+
+        // 3. mean square -> RMS
+        if (mode == Mode::rms)
+            for (int i = 0; i < numSamples; ++i)
+                envelope[i] = std::sqrt (envelope[i]);
+    }
+
+private:
+    float calculateCoefficient (double timeMs) const
+    {
+        return timeMs <= 0.0 ? 0.0f : static_cast<float> (DeterministicMath::exp (-1000.0 / (timeMs * fs)));
+    }
+
+    double fs = 44100.0;
+    double attackMs = 10.0;
+    double releaseMs = 100.0;
+    float attackCoeff = 0.0f;
+    float releaseCoeff = 0.0f;
+    float state = 0.0f;
+    Mode mode = Mode::peak;
+};
@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+    FeedbackDelayNetwork.cpp
+    Created: 19 Oct 2026
+
+    Modulated feedback delay network for stereo flanging / chorus.
+
+  ==============================================================================
+*/
+
+#include "FeedbackDelayNetwork.h"
+#include "DeterministicMath.h"
+
+namespace
+{
+    // Base delays of the lines in milliseconds (roughly spread out and with no common factors, so that the comb filters of the lines don't line up)
+    const double baseDelaysMs[FeedbackDelayNetwork::maxNumLines] = { 1.0, 1.37, 1.71, 2.13, 2.57, 3.1, 3.53, 4.1 };
+}
+
+void FeedbackDelayNetwork::prepare (double sampleRate, int maxModulationToSet)
+{
+    fs = sampleRate;
+    maxModulation = maxModulationToSet;
+
+    for (int l = 0; l < maxNumLines; ++l)
+        baseDelay[l] = static_cast<float> (baseDelaysMs[l] * 0.001 * fs);
+
+    // + 2 for the linear interpolation
+    lineLength = nextPowerOfTwo (static_cast<int> (baseDelay[maxNumLines - 1]) + maxModulation + 2);
+    lineMask = lineLength - 1;
+    lines.resize (static_cast<size_t> (maxNumLines * lineLength));
+
+    reset();
+}
+
+void FeedbackDelayNetwork::reset()
+{
+    std::fill (lines.begin(), lines.end(), 0.0f);
+    writeLoc = 0;
+
+    // Spread the phases of the LFOs evenly
+    for (int l = 0; l < maxNumLines; ++l)
+    {
+        const double phase = 2.0 * double_Pi * l / numLines;
+        lfoSin[l] = static_cast<float> (DeterministicMath::sin (phase));
+        lfoCos[l] = static_cast<float> (DeterministicMath::sin (phase + 0.5 * double_Pi));
+    }
+
+    samplesUntilRenormalisation = renormalisationInterval;
+    rampsNeedStart = true;
+}
+
+void FeedbackDelayNetwork::restartLFOs()
+{
+    for (int l = 0; l < maxNumLines; ++l)
+    {
+        const double phase = 2.0 * double_Pi * l / numLines - 0.5 * double_Pi;
+        lfoSin[l] = static_cast<float> (DeterministicMath::sin (phase));
+        lfoCos[l] = static_cast<float> (DeterministicMath::sin (phase + 0.5 * double_Pi));
+    }
+}
+
+void FeedbackDelayNetwork::setNumLines (int numLinesToSet)
+{
+    requestedNumLines.store (jlimit (2, maxNumLines, numLinesToSet & ~1), std::memory_order_relaxed); // an even number, so that both channels have the same number of lines
+}
+
+void FeedbackDelayNetwork::updateNumLines()
+{
+    int newNumLines = requestedNumLines.load (std::memory_order_relaxed);
+    if (halveLines)
+        newNumLines = jmax (2, (newNumLines / 2) & ~1);
+    if (newNumLines == numLines)
+        return;
+
+    // The lines that become active still hold the signal (and LFO phase) from when they were last used
+    for (int l = numLines; l < newNumLines; ++l)
+    {
+        std::fill (lines.begin() + l * lineLength, lines.begin() + (l + 1) * lineLength, 0.0f);
+
+        // Rotate the phasor of the first line by 2 * pi * l / N
+        const double offset = 2.0 * double_Pi * l / newNumLines;
+        const float offsetSin = static_cast<float> (DeterministicMath::sin (offset));
+        const float offsetCos = static_cast<float> (DeterministicMath::sin (offset + 0.5 * double_Pi));
+        lfoSin[l] = lfoSin[0] * offsetCos + lfoCos[0] * offsetSin;
+        lfoCos[l] = lfoCos[0] * offsetCos - lfoSin[0] * offsetSin;
+    }
+
+    numLines = newNumLines;
+}
+
+double FeedbackDelayNetwork::getTailLengthSeconds() const
+{
+    // The Householder matrix is orthogonal, so the energy in the network drops by the feedback on every pass through a line
+    const double longestDelay = (baseDelay[maxNumLines - 1] + maxModulation + 1) / fs;
+    const double fb = jlimit (0.0, 0.999, static_cast<double> (feedback.load (std::memory_order_relaxed)));
+    const double numPasses = fb > 0.0 ? jmax (1.0, std::log (0.001) / std::log (fb)) : 1.0;
+    return numPasses * longestDelay;
+}
+
+void FeedbackDelayNetwork::renormaliseLFOs()
+{
+    for (int l = 0; l < numLines; ++l)
+    {
+        const float correctionFactor = 0.5f * (3.0f - (lfoSin[l] * lfoSin[l] + lfoCos[l] * lfoCos[l]));
+        lfoSin[l] *= correctionFactor;
+        lfoCos[l] *= correctionFactor;
+    }
+}
+
+void FeedbackDelayNetwork::process (float* left, float* right, int numSamples, double rate, double depth, double gain)
+{
+    updateNumLines();
+    const int N = numLines;
+
+    if (rampsNeedStart)
+    {
+        previousDepth = static_cast<float> (depth);
+        previousGain = static_cast<float> (gain);
+        rampsNeedStart = false;
+    }
+
+    // Rotation of the LFO phasors per sample (computed once per tile)
+    const double phaseInc = 2.0 * double_Pi * rate / fs;
+    const float rotSin = static_cast<float> (DeterministicMath::sin (phaseInc));
+    const float rotCos = static_cast<float> (DeterministicMath::sin (phaseInc + 0.5 * double_Pi));
+
+    const float depthStep = (static_cast<float> (depth) - previousDepth) / numSamples;
+    const float gainStep = (static_cast<float> (gain) - previousGain) / numSamples;
+    float rampedDepth = previousDepth;
+    float rampedGain = previousGain;
+
+    const float householder = 2.0f / N;
+    const float outputScaling = 2.0f / N;  // every channel sums N / 2 lines
+    const float modulation = 0.5f * maxModulation;
+    const float fb = feedback.load (std::memory_order_relaxed);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        rampedDepth += depthStep;
+        rampedGain += gainStep;
+
+        const float inputL = rampedGain * left[i];
+        const float inputR = rampedGain * right[i];
+        const float lineDepth = rampedDepth * modulation;
+
+        // 1. Modulated reads (linear interpolation) and rotation of the LFO phasors
+        for (int l = 0; l < N; ++l)
+        {
+            const float delay = baseDelay[l] + lineDepth * (1.0f + lfoSin[l]);
+            const int intDelay = static_cast<int> (delay);
+            const float frac = delay - static_cast<float> (intDelay);
+
+            const float* line = lines.data() + l * lineLength;
+            const float a = line[(writeLoc - intDelay) & lineMask];
+            const float b = line[(writeLoc - intDelay - 1) & lineMask];
+            lineOutput[l] = a + frac * (b - a);
+
+            const float s = lfoSin[l] * rotCos + lfoCos[l] * rotSin;
+            lfoCos[l] = lfoCos[l] * rotCos - lfoSin[l] * rotSin;
+            lfoSin[l] = s;
+        }
+
+        // 2. Householder matrix: y = x - (2 / N) * sum (x)
+        float sum = 0.0f;
+        for (int l = 0; l < N; ++l)
+            sum += lineOutput[l];
+        const float correction = householder * sum;
+
+        // 3. Write the inputs plus the mixed feedback into the lines and sum the outputs per channel
+        float wetL = 0.0f;
+        float wetR = 0.0f;
+        for (int l = 0; l < N; l += 2)
+        {
+            lines[l * lineLength + writeLoc] = inputL + fb * (lineOutput[l] - correction);
+            lines[(l + 1) * lineLength + writeLoc] = inputR + fb * (lineOutput[l + 1] - correction);
+            wetL += lineOutput[l];
+            wetR += lineOutput[l + 1];
+        }
+
+        left[i] = inputL + outputScaling * wetL;
+        right[i] = inputR + outputScaling * wetR;
+
+        writeLoc = (writeLoc + 1) & lineMask;
+
+        if (--samplesUntilRenormalisation == 0)
+        {
+            renormaliseLFOs();
+            samplesUntilRenormalisation = renormalisationInterval;
+        }
+    }
+
+    previousDepth = static_cast<float> (depth);
+    previousGain = static_cast<float> (gain);
+}
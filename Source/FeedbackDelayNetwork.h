@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    FeedbackDelayNetwork.h
+    Created: 19 Oct 2026
+
+    Modulated feedback delay network for stereo flanging / chorus.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Feedback delay network with 2 to 8 modulated delay lines and a Householder feedback matrix.
+
+    Every line has its own base delay and its own LFO (the LFOs are spread evenly in phase). The even lines are fed by
+    (and summed into) the left channel and the odd lines the right channel. The outputs of the lines are mixed with the
+    Householder matrix  H = I - (2 / N) * 1 * 1^T  (which is orthogonal, so the network is stable for any feedback below 1)
+    and fed back into the lines.
+
+    The state is stored as a structure of arrays (one array per quantity, indexed by line) and the per-line work is done in
+    loops over the lines, so that the compiler can vectorise them. The LFOs are rotating phasors (a complex multiplication per
+    sample) so there are no sin() calls per sample. Per sample, the cost is proportional to the number of lines: the
+    Householder matrix needs one sum over the lines rather than a full N x N matrix multiplication.
+*/
+class FeedbackDelayNetwork
+{
+public:
+    static constexpr int maxNumLines = 8;
+
+    FeedbackDelayNetwork() = default;
+
+    // Allocates the delay lines. maxModulation is the maximum modulation depth in samples.
+    void prepare (double sampleRate, int maxModulation);
+    void reset();
+
+    /*
+     These can be called from any thread; the audio thread picks the values up at the start of the next tile.
+     Lines that become active are cleared and their LFOs are spread evenly in phase after the LFO of the first line.
+     */
+    void setNumLines (int numLinesToSet);
+    void setFeedback (float feedbackToSet) { feedback.store (feedbackToSet, std::memory_order_relaxed); };
+
+    // Time for the output to decay by 60 dB after the input stops, for the current feedback and the longest possible delay
+    double getTailLengthSeconds() const;
+    
+    // Restarts the LFOs: the first line at its minimum delay, the others spread evenly in phase after it
+    void restartLFOs();
+    
+    /*
+     For the CPU governor (audio thread only; applied at the start of the next tile): runs half of the lines set with setNumLines()
+     (rounded down to an even number, at least 2). canHalveLines() tells whether that saves anything (it doesn't with 2 lines).
+     */
+    void setHalveLines (bool shouldHalveLines) { halveLines = shouldHalveLines; };
+    bool canHalveLines() const { return requestedNumLines.load (std::memory_order_relaxed) > 2; };
+
+    /*
+     Processes a stereo tile in place. The LFO rate is in Hz and the depth between 0 and 1 (times the maxModulation passed to prepare()).
+     Gain and depth ramp from their values at the end of the previous tile (after reset(), they start at the values passed in).
+     The output doesn't depend on how the signal is split into tiles if rate, depth and gain are constant.
+     */
+    void process (float* left, float* right, int numSamples, double rate, double depth, double gain);
+
+private:
+    double fs = 44100.0;
+    int maxModulation = 0;
+    int numLines = 4;                           // audio thread
+    std::atomic<int> requestedNumLines { 4 };   // set by setNumLines()
+    bool halveLines = false;                    // set by setHalveLines()
+    std::atomic<float> feedback { 0.5f };
+
+    // Applies requestedNumLines and halveLines (audio thread)
+    void updateNumLines();
+
+    // All lines are stored in one buffer (line l starts at l * lineLength)
+    std::vector<float> lines;
+    int lineLength = 0;     // a power of two
+    int lineMask = 0;
+    int writeLoc = 0;
+
+    // ==== Per-line state (structure of arrays) ==== //
+    std::array<float, maxNumLines> baseDelay {};   // in samples
+    std::array<float, maxNumLines> lfoSin {};      // the LFO phasors
+    std::array<float, maxNumLines> lfoCos {};
+    std::array<float, maxNumLines> lineOutput {};  // scratch space for the outputs of the lines
+
+    float previousDepth = 0.0f;
+    float previousGain = 0.0f;
+    bool rampsNeedStart = true;     // set by reset(): the next tile starts at its own depth and gain instead of ramping from 0
+
+    /*
+     The LFO phasors are put back on the unit circle (rounding errors make them drift slowly) every renormalisationInterval samples.
+     This counts samples rather than tiles, so that the LFOs don't depend on the tile sizes.
+     */
+    static constexpr int renormalisationInterval = 256;
+    int samplesUntilRenormalisation = renormalisationInterval;
+    void renormaliseLFOs();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FeedbackDelayNetwork)
+};
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    FractionalDelay.h
+    Created: 19 Oct 2026
+
+    Building blocks of the flanger's read path: the table-based fixed-point LFO and the linear reads of a delay line
+    at a fractional delay, in fixed-point (Q16.16) and floating-point.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DeterministicMath.h"
+
+/*
+    Both read paths are compiled regardless of NORDICSMC_FIXED_POINT_READ (see PluginProcessor.h), which only selects the one
+    the processor uses. This way the tests can check the error bound of the fixed-point path and compare the cost of the two.
+
+    Formats:
+        - LFO phase: 32-bit accumulator (2^32 = 2 pi), so that it wraps around by itself
+        - LFO value: (1 + sin) / 2 in Q2.30
+        - Delay: Q16.16 samples (uint32_t) or samples (double)
+*/
+namespace FractionalDelay
+{
+    static constexpr int sineTableBits = 11; // the LFO table has 2^sineTableBits entries (+1 guard point)
+
+    // One period of (1 + sin) / 2 in Q2.30, plus a guard point so that the interpolation never has to wrap around
+    inline std::vector<int64_t> makeLfoTable()
+    {
+        std::vector<int64_t> table ((1 << sineTableBits) + 1);
+        for (int i = 0; i <= (1 << sineTableBits); ++i)
+            table[i] = static_cast<int64_t> (std::round ((1.0 + DeterministicMath::sin (2.0 * double_Pi * i / (1 << sineTableBits))) * 0.5 * (1 << 30)));
+
+        return table;
+    }
+
+    // Phase increment per sample of an LFO at "rate" Hz (quantised to fs / 2^32)
+    inline uint32_t phaseIncrement (double rate, double fs)
+    {
+        return static_cast<uint32_t> (rate / fs * 4294967296.0);
+    }
+
+    // Linearly interpolated lookup of (1 + sin) / 2 in Q2.30. The top bits of the phase are the table index, the next 16 bits the interpolation coefficient.
+    inline int64_t lookupLfo (const std::vector<int64_t>& table, uint32_t phase)
+    {
+        const uint32_t tableIdx = phase >> (32 - sineTableBits);
+        const int64_t tableFrac = (phase >> (16 - sineTableBits)) & 0xffff;
+        return table[tableIdx] + (((table[tableIdx + 1] - table[tableIdx]) * tableFrac) >> 16);
+    }
+
+    // Delay in Q16.16 samples for an LFO value in Q2.30 and a depth in Q16.16 samples
+    inline uint32_t delayQ16 (int64_t lfo, int64_t depthQ16)
+    {
+        return static_cast<uint32_t> ((lfo * depthQ16) >> 30);
+    }
+
+    /*
+     Reads a delay line (whose length is delayMask + 1, a power of two) at "delay" Q16.16 samples behind writeLoc, using linear interpolation.
+     The read position is a Q16.16 number as well. Unsigned wrap-around plus masking the integer part takes care of negative positions.
+     The position lies between readLoc and readLoc + 1, and its fractional bits are used directly as the interpolation coefficient.
+     */
+    inline float readLinear (const std::vector<float>& delayLine, int writeLoc, int delayMask, uint32_t delay)
+    {
+        const uint32_t readPos = (static_cast<uint32_t> (writeLoc) << 16) - delay;
+        const int readLoc = static_cast<int> (readPos >> 16) & delayMask;
+        const int readLoc2 = (readLoc + 1) & delayMask;
+        const float frac = static_cast<float> (readPos & 0xffff) * (1.0f / 65536.0f);
+
+        return delayLine[readLoc] + frac * (delayLine[readLoc2] - delayLine[readLoc]);
+    }
+
+    // As above, with the delay in samples
+    inline float readLinear (const std::vector<float>& delayLine, int writeLoc, int delayMask, double delay)
+    {
+        // Fractional part of the delay to be used for fractional delay
+        double frac = delay - floor (delay);
+
+        /*
+         Normally we would simply subtract the delay from the write location to get the read location. This might, however, result in negative indices.
+         As the length of the delay line is a power of two, masking with (length - 1) wraps these around to the end of the delay line.
+         */
+        const int readLoc = (writeLoc - static_cast<int> (floor (delay))) & delayMask;
+
+        // 2nd read location is used for the fractional delay
+        const int readLoc2 = (readLoc - 1) & delayMask;
+
+        return static_cast<float> ((1.0 - frac) * delayLine[readLoc] + frac * delayLine[readLoc2]);
+    }
+}
@@ -30,6 +30,24 @@ NordicSMC_EffectAudioProcessorEditor::NordicSMC_EffectAudioProcessorEditor (Nord
 
     LFOfreq.setRange (0.0, 10.0, 0.01);
     LFOfreq.setValue (2.0, dontSendNotification);
+
+    envToDepth.setRange (0.0, 1.0, 0.01);
+    envToDepth.setValue (0.0, dontSendNotification);
+
+    envToRate.setRange (0.0, 1.0, 0.01);
+    envToRate.setValue (0.0, dontSendNotification);
+
+    envAttack.setRange (0.0, 200.0, 0.1);
+    envAttack.setValue (10.0, dontSendNotification);
+
+    envRelease.setRange (1.0, 2000.0, 1.0);
+    envRelease.setValue (100.0, dontSendNotification);
+
+    feedbackNetworkLines.setRange (2, 8, 2);
+    feedbackNetworkLines.setValue (4, dontSendNotification);
+
+    feedbackNetworkFeedback.setRange (0.0, 0.95, 0.01);
+    feedbackNetworkFeedback.setValue (0.5, dontSendNotification);
     /* Adding parameter control [3]: Add the Editor as a listener to the slider
             
             Once the slider is moved, it will send a message to all listeners, which will call their implementation of the "sliderValueChanged()" function.
@@ -38,6 +56,12 @@ NordicSMC_EffectAudioProcessorEditor::NordicSMC_EffectAudioProcessorEditor (Nord
     frequencySlider.addListener (this);
     LFOdepth.addListener (this);
     LFOfreq.addListener (this);
+    envToDepth.addListener (this);
+    envToRate.addListener (this);
+    envAttack.addListener (this);
+    envRelease.addListener (this);
+    feedbackNetworkLines.addListener (this);
+    feedbackNetworkFeedback.addListener (this);
 
     /* Adding parameter control [4]: Make the slider visible
      
@@ -47,19 +71,150 @@ NordicSMC_EffectAudioProcessorEditor::NordicSMC_EffectAudioProcessorEditor (Nord
     addAndMakeVisible (frequencySlider);
     addAndMakeVisible (LFOdepth);
     addAndMakeVisible (LFOfreq);
+    addAndMakeVisible (envToDepth);
+    addAndMakeVisible (envToRate);
+    addAndMakeVisible (envAttack);
+    addAndMakeVisible (envRelease);
+    addAndMakeVisible (feedbackNetworkLines);
+    addAndMakeVisible (feedbackNetworkFeedback);
+    
+    // The item IDs are the StereoMode values + 1 (an ID of 0 is not allowed in a ComboBox)
+    stereoModeBox.addItem ("Mono", 1);
+    stereoModeBox.addItem ("Stereo (linked)", 2);
+    stereoModeBox.addItem ("Stereo (inverted LFO)", 3);
+    stereoModeBox.addItem ("Mid/Side", 4);
+    stereoModeBox.addItem ("Feedback network", 5);
+    stereoModeBox.setSelectedId (1, dontSendNotification);
+    stereoModeBox.onChange = [this] {
+        audioProcessor.setStereoMode (static_cast<NordicSMC_EffectAudioProcessor::StereoMode> (stereoModeBox.getSelectedId() - 1));
+    };
+    addAndMakeVisible (stereoModeBox);
+    
+    // The item IDs are the EnvelopeFollower::Mode values + 1
+    envModeBox.addItem ("Envelope: peak", 1);
+    envModeBox.addItem ("Envelope: RMS", 2);
+    envModeBox.setSelectedId (1, dontSendNotification);
+    envModeBox.onChange = [this] {
+        audioProcessor.setEnvMode (static_cast<EnvelopeFollower::Mode> (envModeBox.getSelectedId() - 1));
+    };
+    addAndMakeVisible (envModeBox);
+    
+    refreshPresetBox();
+    presetBox.onChange = [this] {
+        const int index = presetBox.getSelectedId() - 1;
+        audioProcessor.setCurrentProgram (index);
+        
+        // The processor morphs to the preset by itself, so only update the sliders
+        const auto& parameters = audioProcessor.getPresetBank().getPreset (index).parameters;
+        gainSlider.setValue (parameters.gain, dontSendNotification);
+        LFOfreq.setValue (parameters.freqLFO, dontSendNotification);
+        LFOdepth.setValue (parameters.depthLFO, dontSendNotification);
+        envToDepth.setValue (parameters.envToDepth, dontSendNotification);
+        envToRate.setValue (parameters.envToRate, dontSendNotification);
+    };
+    addAndMakeVisible (presetBox);
+    
+    savePresetButton.onClick = [this] { showSavePresetWindow(); };
+    addAndMakeVisible (savePresetButton);
+    
+    lookaheadLimiterButton.onClick = [this] { audioProcessor.setLookaheadLimiter (lookaheadLimiterButton.getToggleState()); };
+    addAndMakeVisible (lookaheadLimiterButton);
 
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (400, 800);
+    
+    // The analyser only runs while the editor is open
+    audioProcessor.getSpectrumAnalyser().start();
+    startTimerHz (30);
 }
 
 NordicSMC_EffectAudioProcessorEditor::~NordicSMC_EffectAudioProcessorEditor()
 {
+    stopTimer();
+    audioProcessor.getSpectrumAnalyser().stop();
+}
+
+void NordicSMC_EffectAudioProcessorEditor::refreshPresetBox()
+{
+    // The item IDs are the preset indices + 1
+    presetBox.clear (dontSendNotification);
+    auto& presetBank = audioProcessor.getPresetBank();
+    for (int i = 0; i < presetBank.getNumPresets(); ++i)
+        presetBox.addItem (presetBank.getPreset (i).name, i + 1);
+    presetBox.setSelectedId (audioProcessor.getCurrentProgram() + 1, dontSendNotification);
+}
+
+void NordicSMC_EffectAudioProcessorEditor::showSavePresetWindow()
+{
+    savePresetWindow = std::make_unique<AlertWindow> ("Save preset", "Name of the preset:", AlertWindow::NoIcon);
+    savePresetWindow->addTextEditor ("name", audioProcessor.getProgramName (audioProcessor.getCurrentProgram()));
+    savePresetWindow->addButton ("Save", 1, KeyPress (KeyPress::returnKey));
+    savePresetWindow->addButton ("Cancel", 0, KeyPress (KeyPress::escapeKey));
+    
+    // The window is modal but asynchronous; the callback checks that the editor still exists
+    Component::SafePointer<NordicSMC_EffectAudioProcessorEditor> editor (this);
+    savePresetWindow->enterModalState (true, ModalCallbackFunction::create ([editor] (int result) {
+        if (editor == nullptr || editor->savePresetWindow == nullptr)
+            return;
+        
+        const String name = editor->savePresetWindow->getTextEditorContents ("name").trim();
+        editor->savePresetWindow->setVisible (false);
+        
+        // Saving adds the preset to the bank (or replaces the user preset of the same name) and selects it
+        if (result == 1 && name.isNotEmpty() && editor->audioProcessor.saveUserPreset (name) >= 0)
+            editor->refreshPresetBox();
+    }));
 }
 
 //==============================================================================
 void NordicSMC_EffectAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    g.setColour (Colours::black);
+    g.fillRect (spectrumArea);
+    
+    g.setColour (Colours::orange);
+    g.strokePath (spectrumPath, PathStrokeType (1.0f));
+}
+
+void NordicSMC_EffectAudioProcessorEditor::timerCallback()
+{
+    if (audioProcessor.getSpectrumAnalyser().readFrame (spectrum))
+    {
+        updateSpectrumPath();
+        repaint (spectrumArea);
+    }
+}
+
+void NordicSMC_EffectAudioProcessorEditor::updateSpectrumPath()
+{
+    spectrumPath.clear();
+    if (spectrum.empty() || spectrumArea.getWidth() <= 0)
+        return;
+    
+    // Logarithmic frequency axis from 20 Hz to 20 kHz, and a dB axis from 0 dB (top) to SpectrumAnalyser::minDb (bottom)
+    const double binWidth = audioProcessor.getSpectrumAnalyser().getSampleRate() / SpectrumAnalyser::fftSize;
+    const float width = static_cast<float> (spectrumArea.getWidth());
+    const float height = static_cast<float> (spectrumArea.getHeight());
+    
+    bool started = false;
+    for (int bin = 1; bin < static_cast<int> (spectrum.size()); ++bin)
+    {
+        const double frequency = bin * binWidth;
+        if (frequency < 20.0)
+            continue;
+        if (frequency > 20000.0)
+            break;
+        
+        const float x = spectrumArea.getX() + width * static_cast<float> (std::log (frequency / 20.0) / std::log (1000.0));
+        const float y = spectrumArea.getY() + height * spectrum[bin] / SpectrumAnalyser::minDb;
+        
+        if (started)
+            spectrumPath.lineTo (x, y);
+        else
+            spectrumPath.startNewSubPath (x, y);
+        started = true;
+    }
 }
 
 void NordicSMC_EffectAudioProcessorEditor::resized()
@@ -82,12 +237,28 @@ void NordicSMC_EffectAudioProcessorEditor::resized()
      A smarter way to locate your sliders in your app is to use a Rectangle<int> instance and call its removeFrom..() functions.
      */
     Rectangle<int> area = getLocalBounds();
-    // We have 4 sliders the height of one is 1/4 the height of the app
-    int sliderHeight = getHeight() * 0.25;
+    Rectangle<int> topRow = area.removeFromTop (30);
+    lookaheadLimiterButton.setBounds (topRow.removeFromRight (150).reduced (4));
+    stereoModeBox.setBounds (topRow.reduced (4));
+    Rectangle<int> secondRow = area.removeFromTop (30);
+    envModeBox.setBounds (secondRow.removeFromRight (150).reduced (4));
+    savePresetButton.setBounds (secondRow.removeFromRight (60).reduced (4));
+    presetBox.setBounds (secondRow.reduced (4));
+    spectrumArea = area.removeFromTop (140).reduced (4);
+    updateSpectrumPath();
+    
+    // We have 10 sliders the height of one is 1/10 the (remaining) height of the app
+    int sliderHeight = area.getHeight() / 10;
     gainSlider.setBounds (area.removeFromTop (sliderHeight));
     frequencySlider.setBounds (area.removeFromTop (sliderHeight));
     LFOfreq.setBounds (area.removeFromTop (sliderHeight));
     LFOdepth.setBounds (area.removeFromTop (sliderHeight));
+    envToDepth.setBounds (area.removeFromTop (sliderHeight));
+    envToRate.setBounds (area.removeFromTop (sliderHeight));
+    envAttack.setBounds (area.removeFromTop (sliderHeight));
+    envRelease.setBounds (area.removeFromTop (sliderHeight));
+    feedbackNetworkLines.setBounds (area.removeFromTop (sliderHeight));
+    feedbackNetworkFeedback.setBounds (area.removeFromTop (sliderHeight));
 
 
 }
@@ -133,6 +304,30 @@ void NordicSMC_EffectAudioProcessorEditor::sliderValueChanged (Slider* slider)
     {
         audioProcessor.setLFOdepth (LFOdepth.getValue());
     }
+    else if (slider == &envToDepth)
+    {
+        audioProcessor.setEnvToDepth (envToDepth.getValue());
+    }
+    else if (slider == &envToRate)
+    {
+        audioProcessor.setEnvToRate (envToRate.getValue());
+    }
+    else if (slider == &envAttack)
+    {
+        audioProcessor.setEnvAttack (envAttack.getValue());
+    }
+    else if (slider == &envRelease)
+    {
+        audioProcessor.setEnvRelease (envRelease.getValue());
+    }
+    else if (slider == &feedbackNetworkLines)
+    {
+        audioProcessor.setFeedbackNetworkLines (static_cast<int> (feedbackNetworkLines.getValue()));
+    }
+    else if (slider == &feedbackNetworkFeedback)
+    {
+        audioProcessor.setFeedbackNetworkFeedback (feedbackNetworkFeedback.getValue());
+    }
 }
 
 
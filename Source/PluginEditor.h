@@ -15,7 +15,8 @@
 /**
 */
 class NordicSMC_EffectAudioProcessorEditor  : public juce::AudioProcessorEditor,
-                                              public Slider::Listener
+                                              public Slider::Listener,
+                                              private Timer
                                            // Slider functionality setup [1]: Inherit from Slider::Listener class
 
 {
@@ -34,6 +35,16 @@ public:
     void sliderValueChanged (Slider* slider) override;
     
 private:
+    // Takes the newest frame of the analyser (if there is one) and repaints the spectrum
+    void timerCallback() override;
+    void updateSpectrumPath();
+    
+    // Fills presetBox with the presets of the bank and selects the current program
+    void refreshPresetBox();
+    
+    // Asks for a name and saves the current parameters as a user preset
+    void showSavePresetWindow();
+    
     
     // Adding parameter control [1]: Add a slider
     Slider gainSlider;
@@ -41,6 +52,37 @@ private:
     
     Slider LFOdepth;
     Slider LFOfreq;
+    
+    // Amount of sidechain modulation
+    Slider envToDepth;
+    Slider envToRate;
+    
+    // Attack and release time (in ms) and detector of the envelope follower
+    Slider envAttack;
+    Slider envRelease;
+    ComboBox envModeBox;
+    
+    // Settings of the feedback network stereo mode
+    Slider feedbackNetworkLines;
+    Slider feedbackNetworkFeedback;
+    
+    // Selects the StereoMode of the processor
+    ComboBox stereoModeBox;
+    
+    // Selects a preset (program) of the processor
+    ComboBox presetBox;
+    
+    // Saves the current parameters as a user preset (the window asks for its name)
+    TextButton savePresetButton { "Save" };
+    std::unique_ptr<AlertWindow> savePresetWindow;
+    
+    // Spectrum of the output: the path is only rebuilt when the analyser has a new frame, not on every paint()
+    Rectangle<int> spectrumArea;
+    std::vector<float> spectrum;
+    Path spectrumPath;
+    
+    // Switches between the hard clip and the lookahead limiter
+    ToggleButton lookaheadLimiterButton { "Lookahead limiter" };
 
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "AudioThreadAudit.h"
 
 //==============================================================================
 NordicSMC_EffectAudioProcessor::NordicSMC_EffectAudioProcessor()
@@ -16,12 +17,16 @@ NordicSMC_EffectAudioProcessor::NordicSMC_EffectAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    for (auto& lfoDelay : lfoDelays)
+        lfoDelay.resize (maxTileSize);
+    envelopeBuffer.resize (maxTileSize);
 }
 
 NordicSMC_EffectAudioProcessor::~NordicSMC_EffectAudioProcessor()
@@ -37,7 +42,7 @@ const juce::String NordicSMC_EffectAudioProcessor::getName() const
 bool NordicSMC_EffectAudioProcessor::acceptsMidi() const
 {
    #if JucePlugin_WantsMidiInput
-    return true;
+    return true; // MIDI controls the LFO (see handleMidiMessage())
    #else
     return false;
    #endif
@@ -63,31 +68,132 @@ bool NordicSMC_EffectAudioProcessor::isMidiEffect() const
 
 double NordicSMC_EffectAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // The tail of the feedback network (which includes the longest delay of the flanger, maxDelay) covers all the stereo modes
+    return feedbackNetwork.getTailLengthSeconds();
 }
 
 int NordicSMC_EffectAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return presetBank.getNumPresets(); // there is always at least one (factory) preset
 }
 
 int NordicSMC_EffectAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load (std::memory_order_relaxed);
 }
 
 void NordicSMC_EffectAudioProcessor::setCurrentProgram (int index)
 {
+    // The size and the preset are read from the same list, which the message thread never changes (see PresetBank.h)
+    const auto& presets = presetBank.getPresets();
+    if (index < 0 || index >= static_cast<int> (presets.size()))
+        return;
+    
+    /*
+     Hand the parameters of the preset over to the audio thread, which will morph to them (see updatePresetMorph()).
+     This doesn't allocate or lock, and only reads published (immutable) preset lists, so hosts may call it from the audio thread.
+     If two threads select a preset at the same time, the last one to store wins.
+     */
+    currentProgram.store (index, std::memory_order_relaxed);
+    pendingParameters.store (&presets[static_cast<size_t> (index)]->parameters, std::memory_order_release);
 }
 
 const juce::String NordicSMC_EffectAudioProcessor::getProgramName (int index)
 {
-    return {};
+    const auto& presets = presetBank.getPresets();
+    if (index < 0 || index >= static_cast<int> (presets.size()))
+        return {};
+    
+    return presets[static_cast<size_t> (index)]->name;
 }
 
 void NordicSMC_EffectAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    // Presets are renamed by saving them under a new name (see saveUserPreset())
+    juce::ignoreUnused (index, newName);
+}
+
+int NordicSMC_EffectAudioProcessor::saveUserPreset (const juce::String& name)
+{
+    // The targets are the values set by the user (or the preset being morphed to)
+    const int index = presetBank.saveUserPreset (name, targetParameters.load());
+    if (index >= 0)
+    {
+        currentProgram.store (index, std::memory_order_relaxed);
+        updateHostDisplay();
+    }
+    return index;
+}
+
+FlangerParameters NordicSMC_EffectAudioProcessor::TargetParameters::load() const
+{
+    FlangerParameters parameters;
+    parameters.gain = gain.load (std::memory_order_relaxed);
+    parameters.freqLFO = freqLFO.load (std::memory_order_relaxed);
+    parameters.depthLFO = depthLFO.load (std::memory_order_relaxed);
+    parameters.envToDepth = envToDepth.load (std::memory_order_relaxed);
+    parameters.envToRate = envToRate.load (std::memory_order_relaxed);
+    return parameters;
+}
+
+void NordicSMC_EffectAudioProcessor::TargetParameters::store (const FlangerParameters& parameters)
+{
+    gain.store (parameters.gain, std::memory_order_relaxed);
+    freqLFO.store (parameters.freqLFO, std::memory_order_relaxed);
+    depthLFO.store (parameters.depthLFO, std::memory_order_relaxed);
+    envToDepth.store (parameters.envToDepth, std::memory_order_relaxed);
+    envToRate.store (parameters.envToRate, std::memory_order_relaxed);
+}
+
+void NordicSMC_EffectAudioProcessor::setCurrentParameters (const FlangerParameters& parameters)
+{
+    gain = parameters.gain;
+    freqLFO = parameters.freqLFO;
+    depthLFO = parameters.depthLFO;
+    envToDepth = parameters.envToDepth;
+    envToRate = parameters.envToRate;
+}
+
+void NordicSMC_EffectAudioProcessor::updatePresetMorph (int numSamples)
+{
+    /*
+     Start a new morph if a preset has been selected: the preset's values become the targets (replacing the user's values),
+     and the current parameters (possibly halfway through a morph) are the starting point.
+     */
+    if (auto* preset = pendingParameters.exchange (nullptr, std::memory_order_acquire))
+    {
+        targetParameters.store (*preset);
+        midiDepthActive = false;
+        morphStart.gain = gain;
+        morphStart.freqLFO = freqLFO;
+        morphStart.depthLFO = depthLFO;
+        morphStart.envToDepth = envToDepth;
+        morphStart.envToRate = envToRate;
+        morphLength = jmax (1, roundToInt (morphTimeMs * 0.001 * fs));
+        morphPosition = 0;
+    }
+    
+    // The morph heads for the latest targets, so moving a slider during a morph isn't overwritten
+    auto target = targetParameters.load();
+    
+    // The mod wheel sets the depth until the user changes it
+    if (midiDepthActive)
+    {
+        if (target.depthLFO != midiDepthTarget)
+            midiDepthActive = false;
+        else
+            target.depthLFO = midiDepthLFO;
+    }
+    
+    if (morphPosition >= morphLength)
+    {
+        setCurrentParameters (target);
+        return;
+    }
+    
+    // The parameters are set to their values at the end of this tile. Gain and depth ramp towards these within the tile.
+    morphPosition = jmin (morphLength, morphPosition + numSamples);
+    setCurrentParameters (FlangerParameters::interpolate (morphStart, target, static_cast<double> (morphPosition) / morphLength));
 }
 
 //==============================================================================
@@ -97,7 +203,45 @@ void NordicSMC_EffectAudioProcessor::prepareToPlay (double sampleRate, int sampl
     // initialisation that you need..
     
     fs = sampleRate; // Obtain the sample rate from the plugin host (or DAW) when the application starts
-    delayLine.resize (maxDelay);
+    
+    /*
+     The delay line needs to hold maxDelay + 1 samples (the fractional delay reads one sample further back, and the cubic interpolation two).
+     Its length is rounded up to a power of two so that indices can be wrapped around by masking rather than with the (slow) modulo operator.
+     */
+    for (auto& delayLine : delayLines)
+        delayLine.resize (nextPowerOfTwo (maxDelay + 3));
+    delayMask = static_cast<int> (delayLines[0].size()) - 1;
+    envelopeFollower.prepare (fs);
+    feedbackNetwork.prepare (fs, maxDelay);
+    spectrumAnalyser.prepare (fs);
+    
+    truePeakLimiter.prepare (fs, 2);
+    lookaheadLimiterActive = false;
+    setLatencySamples (useLookaheadLimiter ? truePeakLimiter.getLatencyInSamples() : 0);
+    
+    checksumState = checksumOffsetBasis;
+    renderChecksum.store (checksumState);
+    
+    // The budget of a block is numSamples / fs seconds (hosts may send blocks shorter than samplesPerBlock, so it is computed per sample)
+    ticksPerSample = static_cast<double> (Time::getHighResolutionTicksPerSecond()) / fs;
+    cpuLoad = 0.0;
+    samplesSinceTierChange = 0;
+    qualityTier = QualityTier::full;
+    truePeakLimiter.setTruePeakDetection (true);
+    reportedQualityTier.store (static_cast<int> (qualityTier), std::memory_order_relaxed);
+    
+    // Start at the targets (a morph in progress jumps to its end, and the mod wheel's depth is dropped)
+    morphPosition = morphLength;
+    midiDepthActive = false;
+    setCurrentParameters (targetParameters.load());
+    
+    resetState();
+}
+
+void NordicSMC_EffectAudioProcessor::setLookaheadLimiter (bool shouldBeEnabled)
+{
+    useLookaheadLimiter = shouldBeEnabled;
+    setLatencySamples (shouldBeEnabled ? truePeakLimiter.getLatencyInSamples() : 0);
 }
 
 void NordicSMC_EffectAudioProcessor::releaseResources()
@@ -125,6 +269,16 @@ bool NordicSMC_EffectAudioProcessor::isBusesLayoutSupported (const BusesLayout&
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+    
+    // The sidechain is optional and can be mono or stereo
+    if (layouts.inputBuses.size() > 1)
+    {
+        auto sidechain = layouts.getChannelSet (true, 1);
+        if (! sidechain.isDisabled()
+         && sidechain != juce::AudioChannelSet::mono()
+         && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -135,8 +289,17 @@ bool NordicSMC_EffectAudioProcessor::isBusesLayoutSupported (const BusesLayout&
 void NordicSMC_EffectAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    
+    // Debug builds can audit this call for allocations and locks (see AudioThreadAudit.h)
+    const AudioThreadAudit::ScopedAudioThread auditScope;
+    
+    const auto blockStartTicks = Time::getHighResolutionTicks();
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
+    
+    // The channels of the main input come first in the buffer, followed by those of the sidechain (if any)
+    auto mainNumInputChannels = getMainBusNumInputChannels();
+    auto numSidechainChannels = totalNumInputChannels - mainNumInputChannels;
 
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
@@ -144,97 +307,691 @@ void NordicSMC_EffectAudioProcessor::processBlock (juce::AudioBuffer<float>& buf
     // This is here to avoid people getting screaming feedback
     // when they first compile a plugin, but obviously you don't need to keep
     // this code if your algorithm always overwrites all the output channels.
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+    for (auto i = mainNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    /*
+     The block is split at the timestamps of the MIDI events, so that a change lands on the exact sample.
+     The parts in between are processed as usual (no per-sample processing), and if there are no MIDI events the whole block is processed in one go.
+     */
+    int blockFlags = blockIsClean;
+    int startSample = 0;
+    for (const auto metadata : midiMessages)
     {
-        // This is our input buffer. (To be used later)
-        auto input = buffer.getReadPointer (channel);
+        const int eventSample = jlimit (0, buffer.getNumSamples(), metadata.samplePosition);
+        if (eventSample > startSample)
+        {
+            blockFlags |= processRange (buffer, startSample, eventSample - startSample, mainNumInputChannels, numSidechainChannels);
+            startSample = eventSample;
+        }
+        handleMidiMessage (metadata.data, metadata.numBytes);
+    }
+    blockFlags |= processRange (buffer, startSample, buffer.getNumSamples() - startSample, mainNumInputChannels, numSidechainChannels);
 
-        // This is the pointer our output buffer.
-        // We will use this variable to send data to our speakers.
-        auto* output = buffer.getWritePointer (channel);
-                
+    // The counters count blocks, not tiles (a tile that contained a NaN or Inf has reset the state)
+    if (blockFlags & blockHasNonFinite)
+        numNonFiniteResets.fetch_add (1, std::memory_order_relaxed);
+    if (blockFlags & blockHasDenormals)
+        numDenormalBlocks.fetch_add (1, std::memory_order_relaxed);
+    
+    spectrumAnalyser.pushSamples (buffer.getReadPointer (0), mainNumInputChannels > 1 ? buffer.getReadPointer (1) : nullptr, buffer.getNumSamples());
+    
+    updateGovernor (Time::getHighResolutionTicks() - blockStartTicks, buffer.getNumSamples());
+}
+
+void NordicSMC_EffectAudioProcessor::updateGovernor (int64_t elapsedTicks, int numSamples)
+{
+    if (numSamples <= 0 || ticksPerSample <= 0.0)
+        return;
+    
+    const double load = static_cast<double> (elapsedTicks) / (numSamples * ticksPerSample);
+    cpuLoad += cpuLoadSmoothing * (load - cpuLoad);
+    samplesSinceTierChange += numSamples;
+    
+    auto newTier = qualityTier;
+    if (bitExact.load (std::memory_order_relaxed) || isNonRealtime())
+    {
+        newTier = QualityTier::full;
+    }
+    else if (! useCpuGovernor.load (std::memory_order_relaxed))
+    {
+        newTier = fixedQualityTier.load (std::memory_order_relaxed);
+    }
+    else if (cpuLoad > governorDowngradeLoad && samplesSinceTierChange >= governorDowngradeHoldSeconds * fs)
+    {
+        // Down to the next tier that saves something (if there is none, there's nothing left to give up)
+        for (int tier = static_cast<int> (qualityTier) + 1; tier <= static_cast<int> (QualityTier::reducedNetwork); ++tier)
+        {
+            if (tierSavesCpu (static_cast<QualityTier> (tier)))
+            {
+                newTier = static_cast<QualityTier> (tier);
+                numTierDowngrades.fetch_add (1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+    else if (cpuLoad < governorUpgradeLoad && qualityTier != QualityTier::full
+             && samplesSinceTierChange >= governorUpgradeHoldSeconds * fs)
+    {
+        /*
+         Undo the last degradation that is in effect, i.e. go to the tier just above it. If none of the tiers up to the current one
+         saves anything (e.g., after the stereo mode has changed), go straight back to full quality, which doesn't change the processing.
+         */
+        newTier = QualityTier::full;
+        for (int tier = static_cast<int> (qualityTier); tier > static_cast<int> (QualityTier::full); --tier)
+        {
+            if (tierSavesCpu (static_cast<QualityTier> (tier)))
+            {
+                newTier = static_cast<QualityTier> (tier - 1);
+                numTierUpgrades.fetch_add (1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+    
+    if (newTier != qualityTier)
+    {
+        qualityTier = newTier;
+        samplesSinceTierChange = 0;
+        truePeakLimiter.setTruePeakDetection (qualityTier < QualityTier::samplePeakLimiter);
+    }
+    
+    reportedQualityTier.store (static_cast<int> (qualityTier), std::memory_order_relaxed);
+    reportedCpuLoad.store (static_cast<float> (cpuLoad), std::memory_order_relaxed);
+}
+
+bool NordicSMC_EffectAudioProcessor::tierSavesCpu (QualityTier tier) const
+{
+    const bool isFeedbackNetwork = activeStereoMode == StereoMode::feedbackNetwork;
+    
+    switch (tier)
+    {
+        case QualityTier::linearInterpolation: return ! isFeedbackNetwork; // the network always reads with linear interpolation
+       #if NORDICSMC_FIXED_POINT_READ
+        case QualityTier::controlRateLFO:      return false;                // the table-based LFO has no control-rate version
+       #else
+        case QualityTier::controlRateLFO:      return ! isFeedbackNetwork; // the network's LFOs are phasors: a rotation costs less than the reads
+       #endif
+        case QualityTier::samplePeakLimiter:   return lookaheadLimiterActive;
+        case QualityTier::reducedNetwork:      return isFeedbackNetwork && feedbackNetwork.canHalveLines();
+        case QualityTier::full:                break;
+    }
+    
+    return false;
+}
+
+int NordicSMC_EffectAudioProcessor::processRange (juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int numChannels, int numSidechainChannels)
+{
+    /*
+     Large host buffers (offline rendering can hand us 8192+ samples) are processed in tiles of at most maxTileSize samples.
+     All stages (sanity guard, gain, LFO, delay line, limiter and the copy to the other channels) are done for one tile
+     before moving on to the next one, so the samples of a tile are still in the (L1) cache when the next stage needs them.
+     
+     Measured with 8192-sample blocks, the tiles are not faster than processing the whole block in one go (within +/- 10%, which
+     is the run-to-run noise). What the tiling does buy is that the scratch buffers (lfoDelays, envelopeBuffer) have a fixed size,
+     allocated in the constructor, whatever buffer size the host uses; without tiles they would have to grow on the audio thread.
+     */
+    int flags = blockIsClean;
+    for (int tileStart = startSample; tileStart < startSample + numSamples; tileStart += maxTileSize)
+        flags |= processTile (buffer, tileStart, jmin (maxTileSize, startSample + numSamples - tileStart), numChannels, numSidechainChannels);
+    
+    return flags;
+}
+
+void NordicSMC_EffectAudioProcessor::handleMidiMessage (const uint8* data, int numBytes)
+{
+    /*
+     The raw bytes are decoded here rather than through juce::MidiMessage, which allocates for long (e.g., SysEx) messages.
+     All messages used below are three bytes long; anything else (SysEx, real-time messages, ...) is ignored.
+     */
+    if (numBytes < 3)
+        return;
+    
+    const int type = data[0] & 0xf0;
+    
+    if (type == 0x90 && data[2] > 0) // note-on (velocity 0 is a note-off)
+    {
+        // Restart the LFO at -pi / 2, where (1 + sin) / 2 (and thus the delay) is 0
+        phaseLFO = 0xc0000000u;
+        curPhaseLFO = -0.5 * double_Pi;
+        feedbackNetwork.restartLFOs();
+    }
+    else if (type == 0xb0 && data[1] == 1) // CC 1
+    {
+        // Only the audio thread writes depthLFO, so this is applied by updatePresetMorph() at the start of the next tile
+        midiDepthActive = true;
+        midiDepthLFO = data[2] / 127.0;
+        midiDepthTarget = targetParameters.depthLFO.load (std::memory_order_relaxed);
+    }
+    else if (type == 0xe0) // pitch wheel
+    {
+        // The pitch wheel value is between 0 and 16383 with 8192 in the center
+        // (2^x is computed as exp (x ln 2) with DeterministicMath, so that this is bit-exact as well)
+        const int pitchWheelValue = data[1] | (data[2] << 7);
+        midiRateFactor = DeterministicMath::exp ((pitchWheelValue - 8192) / 8192.0 * 0.6931471805599453);
+    }
+}
+
+int NordicSMC_EffectAudioProcessor::processTile (juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int numChannels, int numSidechainChannels)
+{
+    if (numChannels == 0)
+        return blockIsClean;
+    
+    /*
+     Sanity guard (input): a single NaN or Inf written into the delay line would recirculate
+     and silence the output until the read location has passed it. If the host hands us
+     one, output silence for this tile and start again from a clean state.
+     The sidechain is checked as well, as a NaN in the envelope would end up in the delay.
+     */
+    int flags = blockIsClean;
+    for (int channel = 0; channel < numChannels + numSidechainChannels; ++channel)
+        flags |= scanBlock (buffer.getReadPointer (channel, startSample), numSamples);
+
+    if (flags & blockHasNonFinite)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.clear (channel, startSample, numSamples);
         
-        // Extra variables for clarity.
-        float inputSignal = 0.0;
-        float nonLimitedOutput = 0.0;
+        resetState();
+        return flags;
+    }
+
+    // Switching the bit-exact mode on (or off) starts from a clean state
+    const bool useBitExact = bitExact.load (std::memory_order_relaxed);
+    if (useBitExact != bitExactActive)
+    {
+        bitExactActive = useBitExact;
         
-        // Here, we only do processing on the left channel and copy everything to the right channel
-        if (channel == 0)
+        // Bit-exact renders always use the full quality tier (the CPU governor is off, see updateGovernor())
+        if (useBitExact)
         {
-            // Loop over all the samples in our buffer
-            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            qualityTier = QualityTier::full;
+            samplesSinceTierChange = 0;
+            truePeakLimiter.setTruePeakDetection (true);
+        }
+        
+        resetState();
+        checksumState = checksumOffsetBasis;
+        renderChecksum.store (checksumState, std::memory_order_relaxed);
+    }
+    
+    /*
+     The stereo mode is read once per tile, so that all stages of the tile agree on it (the editor can change it at any time).
+     Delay lines that the previous mode didn't write hold old audio, which would be replayed: clear them when the mode changes.
+     */
+    const StereoMode mode = numChannels > 1 ? stereoMode.load (std::memory_order_relaxed) : StereoMode::mono;
+    if (mode != activeStereoMode)
+    {
+        if (activeStereoMode == StereoMode::mono || activeStereoMode == StereoMode::feedbackNetwork)
+            std::fill (delayLines[1].begin(), delayLines[1].end(), 0.0f);
+        if (activeStereoMode == StereoMode::feedbackNetwork)
+            std::fill (delayLines[0].begin(), delayLines[0].end(), 0.0f);
+        if (mode == StereoMode::feedbackNetwork)
+            feedbackNetwork.reset();
+        
+        activeStereoMode = mode;
+    }
+    
+    updatePresetMorph (numSamples);
+    
+    // Envelope of the sidechain
+    const float* envelope = nullptr;
+    if (numSidechainChannels > 0)
+    {
+        // The follower isn't thread-safe, so the settings from the editor are applied here (only when they change, as they need an exp() each)
+        const double attackMs = envAttackMs.load (std::memory_order_relaxed);
+        const double releaseMs = envReleaseMs.load (std::memory_order_relaxed);
+        if (attackMs != envelopeFollower.getAttack())
+            envelopeFollower.setAttack (attackMs);
+        if (releaseMs != envelopeFollower.getRelease())
+            envelopeFollower.setRelease (releaseMs);
+        envelopeFollower.setMode (envMode.load (std::memory_order_relaxed));
+        
+        const float* sidechain[2] = { buffer.getReadPointer (numChannels, startSample),
+                                      buffer.getReadPointer (numChannels + jmin (numSidechainChannels, 2) - 1, startSample) };
+        envelopeFollower.process (sidechain, jmin (numSidechainChannels, 2), envelopeBuffer.data(), numSamples);
+        envelope = envelopeBuffer.data();
+    }
+    
+    // The feedback network has its own LFOs (one per delay line)
+    if (mode != StereoMode::feedbackNetwork)
+        computeLFO (numSamples, envelope);
+    
+    // Start the lookahead limiter from a clean state when it is switched on
+    const bool useLimiter = useLookaheadLimiter.load (std::memory_order_relaxed);
+    if (useLimiter && ! lookaheadLimiterActive)
+        truePeakLimiter.reset();
+    lookaheadLimiterActive = useLimiter;
+    
+    auto* left = buffer.getWritePointer (0, startSample);
+    
+    if (mode == StereoMode::mono)
+    {
+        processMonoTile (left, numSamples, ! useLimiter);
+        
+        if (useLimiter)
+            truePeakLimiter.process (&left, 1, numSamples);
+        
+        // Copy the left channel to the right channel
+        for (int channel = 1; channel < numChannels; ++channel)
+            FloatVectorOperations::copy (buffer.getWritePointer (channel, startSample), left, numSamples);
+    }
+    else
+    {
+        auto* right = buffer.getWritePointer (1, startSample);
+        
+        switch (mode)
+        {
+            case StereoMode::feedbackNetwork:
             {
-                /* Adding a parameter [2]: Apply to a signal
-                 
-                        Here, we're applying the gain (controlled by the slider) to a sinusoid.
-                 */
-                double phaseInc = 2.0 * double_Pi * freq / fs;
-                curPhase += phaseInc;
-                
-                // ==== Comment out one of the below ==== //
+                // Same modulation as computeLFO(), but evaluated once per tile
+                double rate = freqLFO * midiRateFactor;
+                double depth = depthLFO;
+                if (envelope != nullptr)
+                {
+                    rate *= 1.0 + maxEnvRateFactor * envToRate * envelope[numSamples - 1];
+                    depth = jmin (1.0, depth + envToDepth * envelope[numSamples - 1]);
+                }
+                previousDepthLFO = depthLFO;
+                previousGain = gain;
                 
-                // Use a sinewave
-//                inputSignal = gain * sin (curPhase);
+                // The network's own tier of the CPU governor
+                feedbackNetwork.setHalveLines (qualityTier >= QualityTier::reducedNetwork);
+                feedbackNetwork.process (left, right, numSamples, rate, depth, gain);
                 
-                // Use external input
-                inputSignal = gain * input[i];
-                
-                // ====================================== //
-                
-                // Write the input signal to the delay line at the write location
-                delayLine[writeLoc] = inputSignal;
+                if (! useLimiter)
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        left[i] = limit (left[i], -1.0f, 1.0f);
+                        right[i] = limit (right[i], -1.0f, 1.0f);
+                    }
+                }
+                break;
+            }
+            case StereoMode::linked:   processStereoTile<StereoMode::linked>   (left, right, numSamples, ! useLimiter); break;
+            case StereoMode::inverted: processStereoTile<StereoMode::inverted> (left, right, numSamples, ! useLimiter); break;
+            case StereoMode::midSide:  processStereoTile<StereoMode::midSide>  (left, right, numSamples, ! useLimiter); break;
+            case StereoMode::mono:     break;
+        }
+        
+        if (useLimiter)
+        {
+            float* channels[] = { left, right };
+            truePeakLimiter.process (channels, 2, numSamples);
+        }
+    }
+    
+    /*
+     Sanity guard (output): catches non-finite values produced by the processing itself (e.g., extreme parameter values).
+     The processing runs with denormals flushed to zero, so it can't produce any and only the input is checked for them.
+     */
+    int outputFlags = blockIsClean;
+    for (int channel = 0; channel < numChannels; ++channel)
+        if (containsNonFinite (buffer.getReadPointer (channel, startSample), numSamples))
+            outputFlags = blockHasNonFinite;
 
-                // Calculate the current phase of the LFO
-                double phaseIncLFO = 2.0 * double_Pi * freqLFO / fs;
-                curPhaseLFO += phaseIncLFO;
-                
-                /*
-                 Convert values of the LFO (sinewave) to a value between 0 and maxDelay.
-                 DepthLFO is between 0 and 1 and is controlled by a slider
-                 */
-                double delay = depthLFO * maxDelay * (1.0 + sin (curPhaseLFO)) * 0.5;
-                
-                // Fractional part of the delay to be used for fractional delay
-                double frac = delay - floor(delay);
-
-                /*
-                 Normally we would simply subtract the delay from the write location to get the read location. This might, however, result in negative indices.
-                 In order to prevent this, we add maxDelay (the length of our delay line) before applying the modulo (%) operator.
-                 */
-                readLoc = (writeLoc - static_cast<int> (floor (delay)) + maxDelay) % maxDelay;
-                
-                // 2nd read location is used for the fractional delay
-                int readLoc2 = (writeLoc - static_cast<int> (floor (delay + 1)) + maxDelay) % maxDelay;
+    if (outputFlags & blockHasNonFinite)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.clear (channel, startSample, numSamples);
+        
+        resetState();
+    }
+    
+    if (bitExactActive)
+        updateChecksum (buffer, startSample, numSamples, numChannels);
+    
+    return flags | outputFlags;
+}
 
-                // Add the direct input signal to (fractional) output of the delayline
-                nonLimitedOutput = inputSignal + (1.0 - frac) * delayLine[readLoc] + frac * delayLine[readLoc2];
-                
-                // "Implementing a limiter is the single most important
-                // thing in real-time audio development" - Willemsen, 2021
-                output[i] = limit (nonLimitedOutput, -1.0, 1.0);
-                
-                // Increment the write location and wrap around the length of the delay line
-                writeLoc = (writeLoc + 1) % maxDelay;
+void NordicSMC_EffectAudioProcessor::updateChecksum (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int numChannels)
+{
+    // 64-bit FNV-1a over the bits of the output samples
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            uint32_t bits;
+            std::memcpy (&bits, buffer.getReadPointer (channel, startSample + i), sizeof (bits));
+            
+            for (int byte = 0; byte < 4; ++byte)
+            {
+                checksumState ^= (bits >> (8 * byte)) & 0xff;
+                checksumState *= 1099511628211ull;
+            }
+        }
+    }
+    
+    renderChecksum.store (checksumState, std::memory_order_relaxed);
+}
 
+void NordicSMC_EffectAudioProcessor::computeLFO (int numSamples, const float* envelope)
+{
+    // The sidechain envelope modulates the rate once per tile (using its last value)...
+    double rate = freqLFO * midiRateFactor;
+    if (envelope != nullptr)
+        rate *= 1.0 + maxEnvRateFactor * envToRate * envelope[numSamples - 1];
+    
+    // ...and the depth per sample
+    const double envDepth = envelope != nullptr ? envToDepth : 0.0;
+    
+    auto& lfoDelay = lfoDelays[0];
+    auto& lfoDelayInverted = lfoDelays[1];
+    
+    /*
+     The depth ramps linearly from its value at the end of the previous tile to the current one,
+     so that moving the slider (or morphing to a preset) doesn't make the delay jump.
+     */
+    const double depthStart = previousDepthLFO;
+    const double depthEnd = depthLFO;
+    previousDepthLFO = depthEnd;
+    
+   #if ! NORDICSMC_FIXED_POINT_READ
+    if (! bitExactActive)
+    {
+        // Calculate the phase increment of the LFO
+        double phaseIncLFO = 2.0 * double_Pi * rate / fs;
+        const double depthStep = (depthEnd - depthStart) / numSamples;
+        
+        /*
+         Control-rate LFO (CPU governor): sin() is only evaluated every lfoControlInterval samples and linearly interpolated in between.
+         The control points lie on the same sine as the per-sample LFO, so switching between the two doesn't make the delay jump.
+         */
+        if (qualityTier >= QualityTier::controlRateLFO)
+        {
+            double lfo = (1.0 + sin (curPhaseLFO)) * 0.5;
+            
+            for (int start = 0; start < numSamples; start += lfoControlInterval)
+            {
+                const int length = jmin (lfoControlInterval, numSamples - start);
+                curPhaseLFO += length * phaseIncLFO;
+                const double lfoStep = ((1.0 + sin (curPhaseLFO)) * 0.5 - lfo) / length;
+                
+                for (int i = start; i < start + length; ++i)
+                {
+                    lfo += lfoStep;
+                    
+                    double depth = depthStart + (i + 1) * depthStep;
+                    if (envelope != nullptr)
+                        depth = jmin (1.0, depth + envDepth * envelope[i]);
+                    
+                    lfoDelay[i] = maxDelay * depth * lfo;
+                    lfoDelayInverted[i] = maxDelay * depth - lfoDelay[i];
+                }
             }
-        } else {
+            return;
+        }
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+            curPhaseLFO += phaseIncLFO;
             
-            // Copy the left channel to the right channel
-            for (int i = 0; i < buffer.getNumSamples(); ++i)
-                output[i] = buffer.getWritePointer (channel-1)[i];
+            /*
+             Convert values of the LFO (sinewave) to a value between 0 and maxDelay.
+             DepthLFO is between 0 and 1 and is controlled by a slider
+             */
+            double depth = depthStart + (i + 1) * depthStep;
+            if (envelope != nullptr)
+                depth = jmin (1.0, depth + envDepth * envelope[i]);
+            
+            lfoDelay[i] = maxDelay * depth * (1.0 + sin (curPhaseLFO)) * 0.5;
+            lfoDelayInverted[i] = maxDelay * depth - lfoDelay[i];
+        }
+        return;
+    }
+   #endif
+    
+    // Parameters only change between tiles, so convert them to fixed-point once per tile
+    const uint32_t phaseIncLFO = FractionalDelay::phaseIncrement (rate, fs);
+    const int64_t maxDepthQ16 = static_cast<int64_t> (maxDelay) << 16;
+    const double envDepthQ16 = envDepth * maxDelay * 65536.0;
+    const int64_t depthStepQ16 = static_cast<int64_t> ((depthEnd - depthStart) * maxDelay * 65536.0) / numSamples;
+    int64_t rampedDepthQ16 = static_cast<int64_t> (depthStart * maxDelay * 65536.0);
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Advance the LFO phase accumulator. It wraps around by itself at 2^32 (= 2 pi).
+        phaseLFO += phaseIncLFO;
+        
+        // (1 + sin) / 2 in Q2.30
+        const int64_t lfo = FractionalDelay::lookupLfo (lfoTable, phaseLFO);
+
+        rampedDepthQ16 += depthStepQ16;
+        int64_t depthQ16 = rampedDepthQ16;
+        if (envelope != nullptr)
+            depthQ16 = jmin (maxDepthQ16, depthQ16 + static_cast<int64_t> (envDepthQ16 * envelope[i]));
+        
+        // Delay in Q16.16 samples
+        const uint32_t delayQ16 = FractionalDelay::delayQ16 (lfo, depthQ16);
+        lfoDelay[i] = delayFromQ16 (delayQ16);
+        lfoDelayInverted[i] = delayFromQ16 (static_cast<uint32_t> (depthQ16) - delayQ16);
+    }
+}
+
+float NordicSMC_EffectAudioProcessor::readDelayLine (const std::vector<float>& delayLine, Delay delay) const
+{
+    // Fixed-point (Q16.16) or floating-point read, depending on the Delay type (see FractionalDelay.h)
+    return FractionalDelay::readLinear (delayLine, writeLoc, delayMask, delay);
+}
+
+float NordicSMC_EffectAudioProcessor::readDelayLineCubic (const std::vector<float>& delayLine, Delay delay) const
+{
+    // Integer and fractional part of the delay
+   #if NORDICSMC_FIXED_POINT_READ
+    const int intDelay = static_cast<int> (delay >> 16);
+    const float frac = static_cast<float> (delay & 0xffff) * (1.0f / 65536.0f);
+   #else
+    const int intDelay = static_cast<int> (floor (delay));
+    const float frac = static_cast<float> (delay - intDelay);
+   #endif
+    
+    /*
+     The four points around the read position, from new to old. The newest one is one sample newer than the write location
+     when the delay is below one sample; as that sample doesn't exist yet, it is replaced by the newest sample.
+     */
+    const int readLoc = writeLoc - intDelay;
+    const float yNewer = delayLine[(readLoc + (intDelay > 0 ? 1 : 0)) & delayMask];
+    const float y0 = delayLine[readLoc & delayMask];
+    const float y1 = delayLine[(readLoc - 1) & delayMask];
+    const float yOlder = delayLine[(readLoc - 2) & delayMask];
+    
+    // Catmull-Rom spline between y0 (frac = 0) and y1 (frac = 1)
+    const float c1 = 0.5f * (y1 - yNewer);
+    const float c2 = yNewer - 2.5f * y0 + 2.0f * y1 - 0.5f * yOlder;
+    const float c3 = 0.5f * (yOlder - yNewer) + 1.5f * (y0 - y1);
+    
+    return ((c3 * frac + c2) * frac + c1) * frac + y0;
+}
+
+void NordicSMC_EffectAudioProcessor::processMonoTile (float* channelData, int numSamples, bool hardClip)
+{
+    auto& delayLine = delayLines[0];
+    
+    // Extra variables for clarity.
+    float inputSignal = 0.0;
+    float nonLimitedOutput = 0.0;
+    
+    // Ramp the gain from its value at the end of the previous tile to avoid clicks
+    double rampedGain = previousGain;
+    const double gainStep = (gain - previousGain) / numSamples;
+    previousGain += numSamples * gainStep;
+    
+    // Crossfade between the cubic and linear interpolation when the CPU governor changes the tier
+    const float cubicWeightTarget = qualityTier == QualityTier::full ? 1.0f : 0.0f;
+    float cubicWeight = previousCubicWeight;
+    const float cubicWeightStep = (cubicWeightTarget - previousCubicWeight) / numSamples;
+    previousCubicWeight = cubicWeightTarget;
+
+    // Loop over all the samples in this tile
+    for (int i = 0; i < numSamples; ++i)
+    {
+        /* Adding a parameter [2]: Apply to a signal
+         
+                Here, we're applying the gain (controlled by the slider) to a sinusoid.
+         */
+        double phaseInc = 2.0 * double_Pi * freq / fs;
+        curPhase += phaseInc;
+        
+        // ==== Comment out one of the below ==== //
+        
+        rampedGain += gainStep;
+        cubicWeight += cubicWeightStep;
+        
+        // Use a sinewave
+//        inputSignal = rampedGain * sin (curPhase);
+        
+        // Use external input
+        inputSignal = rampedGain * channelData[i];
+        
+        // ====================================== //
+        
+        // Write the input signal to the delay line at the write location
+        delayLine[writeLoc] = inputSignal;
+
+        // Add the direct input signal to (fractional) output of the delayline
+        nonLimitedOutput = inputSignal + readDelayLineInterpolated (delayLine, lfoDelays[0][i], cubicWeight);
+        
+        // "Implementing a limiter is the single most important
+        // thing in real-time audio development" - Willemsen, 2021
+        // (If the lookahead limiter is used, it is applied to the whole tile afterwards)
+        channelData[i] = hardClip ? limit (nonLimitedOutput, -1.0, 1.0) : nonLimitedOutput;
+        
+        // Increment the write location and wrap around the length of the delay line
+        writeLoc = (writeLoc + 1) & delayMask;
+    }
+}
+
+template <NordicSMC_EffectAudioProcessor::StereoMode mode>
+void NordicSMC_EffectAudioProcessor::processStereoTile (float* left, float* right, int numSamples, bool hardClip)
+{
+    auto& delayLine1 = delayLines[0];
+    auto& delayLine2 = delayLines[1];
+    
+    // Ramp the gain from its value at the end of the previous tile to avoid clicks
+    float g = static_cast<float> (previousGain);
+    const float gainStep = static_cast<float> ((gain - previousGain) / numSamples);
+    previousGain += numSamples * static_cast<double> (gainStep);
+    
+    // Crossfade between the cubic and linear interpolation when the CPU governor changes the tier
+    const float cubicWeightTarget = qualityTier == QualityTier::full ? 1.0f : 0.0f;
+    float cubicWeight = previousCubicWeight;
+    const float cubicWeightStep = (cubicWeightTarget - previousCubicWeight) / numSamples;
+    previousCubicWeight = cubicWeightTarget;
+    
+    /*
+     Both channels are processed in the same loop so that they share the write location and the LFO.
+     For mid/side, encoding and decoding happen in this loop as well, so they don't need extra passes over the buffer.
+     */
+    for (int i = 0; i < numSamples; ++i)
+    {
+        g += gainStep;
+        cubicWeight += cubicWeightStep;
+        
+        float input1, input2;
+        if (mode == StereoMode::midSide)
+        {
+            input1 = 0.5f * g * (left[i] + right[i]); // mid
+            input2 = 0.5f * g * (left[i] - right[i]); // side
+        }
+        else
+        {
+            input1 = g * left[i];
+            input2 = g * right[i];
+        }
+        
+        delayLine1[writeLoc] = input1;
+        delayLine2[writeLoc] = input2;
+        
+        // The second channel uses the inverted LFO in all modes except "linked"
+        const Delay delay1 = lfoDelays[0][i];
+        const Delay delay2 = lfoDelays[mode == StereoMode::linked ? 0 : 1][i];
+        
+        const float output1 = input1 + readDelayLineInterpolated (delayLine1, delay1, cubicWeight);
+        const float output2 = input2 + readDelayLineInterpolated (delayLine2, delay2, cubicWeight);
+        
+        if (mode == StereoMode::midSide)
+        {
+            left[i] = output1 + output2;
+            right[i] = output1 - output2;
         }
+        else
+        {
+            left[i] = output1;
+            right[i] = output2;
+        }
+        
+        if (hardClip)
+        {
+            left[i] = limit (left[i], -1.0, 1.0);
+            right[i] = limit (right[i], -1.0, 1.0);
+        }
+        
+        // Increment the write location and wrap around the length of the delay line
+        writeLoc = (writeLoc + 1) & delayMask;
     }
 }
 
+int NordicSMC_EffectAudioProcessor::scanBlock (const float* data, int numSamples)
+{
+    /*
+     Instead of calling std::isfinite() etc. per sample, look at the bits of the magnitude directly and
+     accumulate the results. The loop has no branches and only needs an add, a subtract and a compare per sample,
+     so the compiler can vectorise it (this runs twice per channel and tile, so it has to stay well below the cost of the flanger).
+     
+            - magnitude + 0x00800000 carries into bit 31 only if the exponent is all ones: Inf or NaN
+            - magnitude - 1 (unsigned) is below 0x007fffff only for a non-zero magnitude with a zero exponent: denormal
+     */
+    uint32_t nonFinite = 0;
+    uint32_t denormal = 0;
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        uint32_t bits;
+        std::memcpy (&bits, data + i, sizeof (bits));
+        
+        const uint32_t magnitude = bits & 0x7fffffffu;
+        
+        nonFinite |= magnitude + 0x00800000u;
+        denormal |= static_cast<uint32_t> (magnitude - 1u < 0x007fffffu);
+    }
+    
+    return ((nonFinite & 0x80000000u) != 0 ? blockHasNonFinite : blockIsClean) | (denormal != 0 ? blockHasDenormals : blockIsClean);
+}
+
+bool NordicSMC_EffectAudioProcessor::containsNonFinite (const float* data, int numSamples)
+{
+    // The Inf/NaN half of scanBlock() (see there)
+    uint32_t nonFinite = 0;
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        uint32_t bits;
+        std::memcpy (&bits, data + i, sizeof (bits));
+        
+        nonFinite |= (bits & 0x7fffffffu) + 0x00800000u;
+    }
+    
+    return (nonFinite & 0x80000000u) != 0;
+}
+
+void NordicSMC_EffectAudioProcessor::resetState()
+{
+    for (auto& delayLine : delayLines)
+        std::fill (delayLine.begin(), delayLine.end(), 0.0f);
+
+    curPhase = 0;
+    curPhaseLFO = 0;
+    phaseLFO = 0;
+    envelopeFollower.reset();
+    feedbackNetwork.reset();
+    truePeakLimiter.reset();
+    writeLoc = 0;
+    previousGain = gain;
+    previousDepthLFO = depthLFO;
+    previousCubicWeight = qualityTier == QualityTier::full ? 1.0f : 0.0f;
+}
+
 //==============================================================================
 bool NordicSMC_EffectAudioProcessor::hasEditor() const
 {
@@ -266,14 +1023,3 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new NordicSMC_EffectAudioProcessor();
 }
-
-// Implementation of the limiter
-float NordicSMC_EffectAudioProcessor::limit (float val, float min, float max)
-{
-    if (val < min)
-        return min;
-    else if (val > max)
-        return max;
-    else
-        return val;
-}
@@ -9,6 +9,31 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "EnvelopeFollower.h"
+#include "TruePeakLimiter.h"
+#include "FeedbackDelayNetwork.h"
+#include "SpectrumAnalyser.h"
+#include "PresetBank.h"
+#include "DeterministicMath.h"
+#include "FractionalDelay.h"
+
+/* Read path of the flanger (selected at compile time)
+ 
+        0: floating-point. The LFO is evaluated with sin() and the delay is split into an integer and fractional part using floor().
+        1: fixed-point. The LFO phase is a 32-bit accumulator advanced by an integer increment and looked up in a precomputed,
+           linearly interpolated table. The read position is a Q16.16 number: its integer part (masked) gives the read location and
+           its fractional bits are the interpolation coefficient, so there is no floor() or floating-point rounding in the read path.
+ 
+        Modulation error of the fixed-point path w.r.t. the exact LFO (in samples of delay, D = depthLFO * maxDelay <= 1000):
+            - table interpolation:  D * (2 pi / 2048)^2 / 16   <= 5.9e-4
+            - Q16.16 truncation:                               <= 1.5e-5
+            - interpolation coefficient (16 bits):             <= 1.5e-5
+        i.e., below 1e-3 samples in total. The LFO frequency is quantised to fs / 2^32 (about 1e-5 Hz at 44.1 kHz).
+        Both paths are implemented in FractionalDelay.h (and compiled either way), and Tests/Source/FractionalDelayTests.cpp checks this bound.
+ */
+#ifndef NORDICSMC_FIXED_POINT_READ
+ #define NORDICSMC_FIXED_POINT_READ 0
+#endif
 
 //==============================================================================
 /**
@@ -54,7 +79,14 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
     
     // Limiter to keep the output signal between -1 and 1. Arguments are: input value, minimum value and maximum value
-    float limit (float val, float min, float max);
+    // (Defined here so that it can be inlined in the per-sample loops)
+    static float limit (float val, float min, float max) { return val < min ? min : (val > max ? max : val); };
+    
+    /* Switches between the hard clip above (default) and the lookahead true-peak limiter (see TruePeakLimiter.h).
+     
+            The lookahead limiter delays the output, so this updates the latency reported to the host.
+     */
+    void setLookaheadLimiter (bool shouldBeEnabled);
     
     
     /* Adding parameter control [6]: Create a "setter" function
@@ -62,11 +94,133 @@ public:
             Rather than making the member variables of your class public, it is good practice to make them private and access them with public "getter/setter" functions.
      
             In order for the slider in the Editor to change the private "gain" variable of this class, a "setter" function must be created.
+     
+            The setters of the preset parameters only set a target value. The audio thread moves the values it uses towards it
+            (immediately, or gradually while it morphs to a preset, see updatePresetMorph()).
      */
-    void setGain (double gainToSet) { gain = gainToSet; };
+    void setGain (double gainToSet) { targetParameters.gain = gainToSet; };
     void setFrequency (double freqToSet) { freq = freqToSet; };
-    void setLFOfreq (double LFOfreqToSet) { freqLFO = LFOfreqToSet; };
-    void setLFOdepth (double LFOdepth) { depthLFO = LFOdepth; };
+    void setLFOfreq (double LFOfreqToSet) { targetParameters.freqLFO = LFOfreqToSet; };
+    void setLFOdepth (double LFOdepth) { targetParameters.depthLFO = LFOdepth; };
+    
+    /* Channel modes (only used when the plugin runs in stereo)
+     
+            - mono:     only the left channel is flanged and copied to the right channel
+            - linked:   both channels are flanged with their own delay line and the same LFO
+            - inverted: as linked, but the LFO of the right channel is 180 degrees out of phase
+            - midSide:  the mid and side signals are flanged (the side with the inverted LFO) and decoded back to left and right
+            - feedbackNetwork: both channels feed a network of modulated delay lines with cross-channel feedback (see FeedbackDelayNetwork.h)
+     */
+    enum class StereoMode
+    {
+        mono,
+        linked,
+        inverted,
+        midSide,
+        feedbackNetwork
+    };
+    void setStereoMode (StereoMode modeToSet) { stereoMode = modeToSet; };
+    
+    // Analyser of the output (shown in the editor, which starts and stops it)
+    SpectrumAnalyser& getSpectrumAnalyser() { return spectrumAnalyser; };
+    
+    // Settings of the feedback network mode: the number of delay lines (2, 4, 6 or 8) and the feedback (below 1)
+    void setFeedbackNetworkLines (int numLines) { feedbackNetwork.setNumLines (numLines); };
+    void setFeedbackNetworkFeedback (double feedback) { feedbackNetwork.setFeedback (static_cast<float> (feedback)); };
+    
+    /* Sidechain modulation
+     
+            The envelope of the sidechain input (if the host connects one) modulates the LFO:
+            - depth: depthLFO + envToDepth * envelope (clipped to 1)
+            - rate:  freqLFO * (1 + maxEnvRateFactor * envToRate * envelope)
+     */
+    void setEnvToDepth (double amount) { targetParameters.envToDepth = amount; };
+    void setEnvToRate (double amount) { targetParameters.envToRate = amount; };
+    void setEnvAttack (double attackMs) { envAttackMs = attackMs; };
+    void setEnvRelease (double releaseMs) { envReleaseMs = releaseMs; };
+    void setEnvMode (EnvelopeFollower::Mode mode) { envMode = mode; };
+
+    /* Bit-exact mode: renders are identical on every (x86-64 and ARM) build, as long as it is compiled without -ffast-math and FMA contraction.
+     
+            The LFO uses the table-based fixed-point path (the table is computed with DeterministicMath::sin()) rather than sin(), and all
+            coefficients are computed with DeterministicMath. Switching the mode on resets the state, so that a render starts from a known state.
+            In this mode, getRenderChecksum() returns a hash (64-bit FNV-1a) of all output samples since the mode was switched on or prepareToPlay() was called.
+            The checksum is independent of the host's buffer size as long as the parameters are constant and there is no sidechain.
+     */
+    void setBitExact (bool shouldBeBitExact) { bitExact = shouldBeBitExact; };
+    uint64_t getRenderChecksum() const { return renderChecksum.load (std::memory_order_relaxed); };
+    
+    /* Presets (see PresetBank.h). Selecting a preset with setCurrentProgram() morphs the parameters to the preset over setPresetMorphTime() milliseconds.
+     
+            Note that presets only change the processor; the editor reads the values of the selected preset with getPresetBank().
+     */
+    const PresetBank& getPresetBank() const { return presetBank; };
+    void setPresetMorphTime (double morphTimeToSet) { morphTimeMs = morphTimeToSet; };
+    
+    // Stores the current parameters as a user preset and returns its index (or -1 if it could not be saved)
+    int saveUserPreset (const juce::String& name);
+
+    /* Counters of the sanity guard in processBlock() (safe to read from any thread).
+     
+            - getNumNonFiniteResets(): how many blocks contained a NaN or Inf (either at the input or the output) and caused the flanger state to be reset
+                                       (once per block, even if several tiles of the block were reset).
+            - getNumDenormalBlocks(): how many blocks contained denormal numbers. These are flushed to zero by ScopedNoDenormals, so they are only counted.
+     */
+    int getNumNonFiniteResets() const { return numNonFiniteResets.load (std::memory_order_relaxed); };
+    int getNumDenormalBlocks() const { return numDenormalBlocks.load (std::memory_order_relaxed); };
+    
+    // Flags returned by scanBlock()
+    enum SanityFlags
+    {
+        blockIsClean = 0,
+        blockHasDenormals = 1,
+        blockHasNonFinite = 2
+    };
+    
+    /*
+     The scans of the sanity guard (public so that their cost can be measured):
+     
+            - scanBlock(): scans a block for NaN, Inf and denormal values and returns a combination of SanityFlags (input)
+            - containsNonFinite(): only checks for NaN and Inf, at about half the cost (output)
+     */
+    static int scanBlock (const float* data, int numSamples);
+    static bool containsNonFinite (const float* data, int numSamples);
+    
+    /* CPU budget governor
+     
+            processBlock() measures its own time against the real-time budget of the block (numSamples / fs). When the smoothed load goes above
+            governorDowngradeLoad, the quality drops by one tier; when it stays below governorUpgradeLoad for governorUpgradeHoldSeconds, it goes up
+            by one tier again. Tiers only change between blocks and are cumulative (every tier includes the savings of the ones above it):
+            - full:                cubic (Catmull-Rom) interpolation of the delay lines, per-sample LFO, true-peak detection in the lookahead limiter
+            - linearInterpolation: linear interpolation of the delay lines (crossfaded over one tile)
+            - controlRateLFO:      the LFO is evaluated every lfoControlInterval samples and linearly interpolated in between
+            - samplePeakLimiter:   the lookahead limiter detects sample peaks rather than (4x oversampled) true peaks
+            - reducedNetwork:      the feedback network runs half of its lines
+     
+            Not every tier saves something in every configuration: the feedback network has neither the interpolation nor the LFO of the
+            other modes (its LFO phasors cost 4 multiplications per line and sample, which a control-rate LFO doesn't beat next to the reads),
+            the fixed-point read path (NORDICSMC_FIXED_POINT_READ) has no control-rate LFO, the sample-peak tier needs the lookahead limiter
+            and a network of 2 lines can't be halved. The governor skips these tiers (see tierSavesCpu()), so that every step changes the
+            processing and getNumTierDowngrades() / getNumTierUpgrades() only count real changes of the quality.
+     
+            The governor is off in bit-exact mode, which always uses the full tier (otherwise the output would depend on the load of the machine),
+            and in offline renders (isNonRealtime()), which have no real-time budget.
+            With the governor switched off (setCpuGovernor (false)), the tier set with setFixedQualityTier() is used (full by default).
+     */
+    enum class QualityTier
+    {
+        full,
+        linearInterpolation,
+        controlRateLFO,
+        samplePeakLimiter,
+        reducedNetwork
+    };
+    void setCpuGovernor (bool shouldBeEnabled) { useCpuGovernor = shouldBeEnabled; };
+    void setFixedQualityTier (QualityTier tier) { fixedQualityTier = tier; };
+    QualityTier getQualityTier() const { return static_cast<QualityTier> (reportedQualityTier.load (std::memory_order_relaxed)); };
+    float getCpuLoad() const { return reportedCpuLoad.load (std::memory_order_relaxed); };  // smoothed fraction of the real-time budget
+    int getNumTierDowngrades() const { return numTierDowngrades.load (std::memory_order_relaxed); };
+    int getNumTierUpgrades() const { return numTierUpgrades.load (std::memory_order_relaxed); };
 
         
 private:
@@ -84,13 +238,190 @@ private:
     double curPhase = 0;
         
     // ==== Flanger variables ==== //
-    std::vector<float> delayLine; // the delay line
+    std::array<std::vector<float>, 2> delayLines; // the delay lines (the second one is only used by the stereo modes)
     int maxDelay = 1000;    // maximum delay (in samples)
     double curPhaseLFO = 0; // the current phase of the LFO
     double freqLFO = 2;     // frequency of the LFO
     double depthLFO = 0.5;  // depth of the LFO (between 0 and 1)
     int writeLoc = 0;       // write location
-    int readLoc = 1;        // read location
+    int delayMask = 0;      // length of the delay line (a power of two) - 1
+    std::atomic<StereoMode> stereoMode { StereoMode::mono }; // set by setStereoMode()
+    StereoMode activeStereoMode = StereoMode::mono;          // mode of the previous tile (audio thread only)
+    
+   #if NORDICSMC_FIXED_POINT_READ
+    // ==== Fixed-point read path ==== //
+    using Delay = uint32_t;                  // delay in Q16.16 samples
+    static Delay delayFromQ16 (uint32_t delayQ16) { return delayQ16; };
+   #else
+    using Delay = double;                    // delay in samples
+    static Delay delayFromQ16 (uint32_t delayQ16) { return delayQ16 * (1.0 / 65536.0); }; // exact
+   #endif
+    
+    // ==== Table-based LFO (used by the fixed-point read path and the bit-exact mode, see FractionalDelay.h) ==== //
+    const std::vector<int64_t> lfoTable { FractionalDelay::makeLfoTable() }; // (1 + sin) / 2 in Q2.30
+    uint32_t phaseLFO = 0;                   // phase of the LFO (2^32 = 2 pi)
+    
+    /*
+     The LFO is evaluated once per tile and shared by all channels. lfoDelays[0] holds the delay for the LFO and lfoDelays[1] for the
+     inverted LFO. The latter is depth - lfoDelays[0][i] (as (1 - sin) / 2 = 1 - (1 + sin) / 2), so it doesn't need another sin() evaluation.
+     */
+    std::array<std::vector<Delay>, 2> lfoDelays;
+    
+    // Fills lfoDelays for the next numSamples samples. "envelope" is the sidechain envelope (or nullptr if there is no sidechain).
+    void computeLFO (int numSamples, const float* envelope);
+    
+    // ==== Sidechain modulation ==== //
+    EnvelopeFollower envelopeFollower;
+    std::atomic<double> envAttackMs { 10.0 };   // settings of the follower from the editor, applied to it on the audio thread
+    std::atomic<double> envReleaseMs { 100.0 };
+    std::atomic<EnvelopeFollower::Mode> envMode { EnvelopeFollower::Mode::peak };
+    std::vector<float> envelopeBuffer; // envelope of the current tile
+    double envToDepth = 0.0;           // amount of depth modulation (between 0 and 1)
+    double envToRate = 0.0;            // amount of rate modulation (between 0 and 1)
+    static constexpr double maxEnvRateFactor = 4.0; // at full modulation, a full-scale envelope speeds up the LFO by a factor 5
+    
+    // Reads a delay line at "delay" samples behind the write location (using linear interpolation for the fractional part)
+    float readDelayLine (const std::vector<float>& delayLine, Delay delay) const;
+    
+    // As readDelayLine(), but with cubic (Catmull-Rom) interpolation, which has less high-frequency loss while the delay is modulated
+    float readDelayLineCubic (const std::vector<float>& delayLine, Delay delay) const;
+    
+    // Crossfades between the linear (cubicWeight = 0) and cubic (cubicWeight = 1) reads, only computing both while crossfading
+    float readDelayLineInterpolated (const std::vector<float>& delayLine, Delay delay, float cubicWeight) const
+    {
+        if (cubicWeight <= 0.0f)
+            return readDelayLine (delayLine, delay);
+        
+        const float cubic = readDelayLineCubic (delayLine, delay);
+        if (cubicWeight >= 1.0f)
+            return cubic;
+        
+        const float linear = readDelayLine (delayLine, delay);
+        return linear + cubicWeight * (cubic - linear);
+    }
+    
+    // Flanger kernels for one tile. The channel data is processed in place and only clipped if hardClip is true.
+    void processMonoTile (float* channelData, int numSamples, bool hardClip);
+    template <StereoMode mode>
+    void processStereoTile (float* left, float* right, int numSamples, bool hardClip);
+    
+    // Values of the gain and depth at the end of the previous tile. Within a tile, these are ramped towards their current values.
+    double previousGain = 0.5;
+    double previousDepthLFO = 0.5;
+    float previousCubicWeight = 1.0f;
+    
+    // ==== Presets ==== //
+    PresetBank presetBank;
+    std::atomic<int> currentProgram { 0 }; // written by setCurrentProgram() (any thread) and saveUserPreset() (message thread)
+    
+    // Parameters of the preset selected with setCurrentProgram(), to be picked up by the audio thread (presets are never deleted while the processor exists)
+    std::atomic<const FlangerParameters*> pendingParameters { nullptr };
+    
+    /*
+     Target values of the preset parameters: written by the setters (message thread) and by the audio thread when it picks up a preset.
+     gain, freqLFO, depthLFO, envToDepth and envToRate are the values the audio thread actually uses, and only it writes them.
+     */
+    struct TargetParameters
+    {
+        std::atomic<double> gain { 0.5 };
+        std::atomic<double> freqLFO { 2.0 };
+        std::atomic<double> depthLFO { 0.5 };
+        std::atomic<double> envToDepth { 0.0 };
+        std::atomic<double> envToRate { 0.0 };
+        
+        FlangerParameters load() const;
+        void store (const FlangerParameters& parameters);
+    };
+    TargetParameters targetParameters;
+    
+    // Sets the values used by the audio thread (without a morph)
+    void setCurrentParameters (const FlangerParameters& parameters);
+    
+    // Morphing between two sets of parameters (audio thread only)
+    FlangerParameters morphStart;
+    int morphLength = 0;    // length of the morph (in samples)
+    int morphPosition = 0;  // samples since the start of the morph
+    double morphTimeMs = 100.0;
+    
+    // Picks up a new preset and advances the morph (towards the latest targets) by numSamples samples
+    void updatePresetMorph (int numSamples);
+    
+    // ==== Bit-exact mode ==== //
+    std::atomic<bool> bitExact { false }; // set by setBitExact()
+    bool bitExactActive = false;          // whether the previous tile was processed in bit-exact mode (audio thread only)
+    uint64_t checksumState = 0;
+    std::atomic<uint64_t> renderChecksum { 0 };
+    static constexpr uint64_t checksumOffsetBasis = 14695981039346656037ull;
+    
+    // Adds the output of a tile to the checksum (sample by sample, so that the result doesn't depend on the tile size)
+    void updateChecksum (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int numChannels);
+    
+    // ==== Feedback network (StereoMode::feedbackNetwork) ==== //
+    FeedbackDelayNetwork feedbackNetwork;
+    
+    // ==== Spectrum analyser (the output is pushed at the end of processBlock()) ==== //
+    SpectrumAnalyser spectrumAnalyser;
+    
+    // ==== Lookahead limiter ==== //
+    TruePeakLimiter truePeakLimiter;
+    std::atomic<bool> useLookaheadLimiter { false }; // set by setLookaheadLimiter()
+    bool lookaheadLimiterActive = false;              // whether the limiter was used for the previous tile (audio thread only)
+    
+    // ==== CPU budget governor ==== //
+    std::atomic<bool> useCpuGovernor { true };  // set by setCpuGovernor()
+    std::atomic<QualityTier> fixedQualityTier { QualityTier::full }; // set by setFixedQualityTier()
+    QualityTier qualityTier = QualityTier::full; // tier of the current block (audio thread only)
+    double ticksPerSample = 0.0;                // high-resolution ticks per sample (the real-time budget of one sample)
+    double cpuLoad = 0.0;                       // smoothed fraction of the budget used by processBlock()
+    int64_t samplesSinceTierChange = 0;         // 64 bits: an int would overflow after 13.5 hours at 44.1 kHz
+    
+    static constexpr double governorDowngradeLoad = 0.7;
+    static constexpr double governorUpgradeLoad = 0.35;
+    static constexpr double governorDowngradeHoldSeconds = 0.1;  // lets the load settle after a change before dropping another tier
+    static constexpr double governorUpgradeHoldSeconds = 2.0;
+    static constexpr double cpuLoadSmoothing = 0.2;              // per block
+    static constexpr int lfoControlInterval = 16;                // samples between LFO evaluations in the controlRateLFO tier
+    
+    std::atomic<int> reportedQualityTier { 0 };
+    std::atomic<float> reportedCpuLoad { 0.0f };
+    std::atomic<int> numTierDowngrades { 0 };
+    std::atomic<int> numTierUpgrades { 0 };
+    
+    // Updates the load with the time of the last block and picks the tier for the next one
+    void updateGovernor (int64_t elapsedTicks, int numSamples);
+    
+    // Whether the tier's degradation saves CPU in the current configuration (the stereo mode and limiter of the last tile)
+    bool tierSavesCpu (QualityTier tier) const;
+    
+    // ==== Tiles and sanity guard ==== //
+    // Number of samples processed in one go. Large host buffers are split into tiles of this size, which is also the size of the scratch buffers (see processRange())
+    static constexpr int maxTileSize = 256;
+    
+    // Processes numSamples samples of the buffer starting at startSample (in tiles) and returns the SanityFlags found in it
+    int processRange (juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int numChannels, int numSidechainChannels);
+    
+    /* Applies a MIDI message to the LFO parameters (processBlock() calls this at the exact sample the message occurs at)
+     
+            - note-on:          restarts the LFO at its minimum delay (in the feedback network mode: the LFO of the first line, with the others spread evenly after it)
+            - CC 1 (mod wheel): LFO depth (0 - 127 maps to 0 - 1), until the depth is set with setLFOdepth() or a preset is selected
+            - pitch wheel:      LFO rate, +/- 1 octave around the rate set with setLFOfreq()
+     */
+    void handleMidiMessage (const uint8* data, int numBytes);
+    double midiRateFactor = 1.0; // set by the pitch wheel
+    
+    // Depth set by the mod wheel, which overrides the target depth (see updatePresetMorph())
+    bool midiDepthActive = false;
+    double midiDepthLFO = 0.5;
+    double midiDepthTarget = 0.5; // target depth when the mod wheel was moved (a different target means that the user has moved the slider since)
+    
+    // Processes one tile of the buffer (all channels and stages) and returns the SanityFlags found in it
+    int processTile (juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int numChannels, int numSidechainChannels);
+    
+    // Clears the delay lines and resets all phases and the write location
+    void resetState();
+    
+    std::atomic<int> numNonFiniteResets { 0 };
+    std::atomic<int> numDenormalBlocks { 0 };
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NordicSMC_EffectAudioProcessor)
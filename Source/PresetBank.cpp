@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+    Created: 19 Oct 2026
+
+    Factory presets (embedded in the binary) and user presets (stored on disk).
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+namespace
+{
+    struct FactoryPreset
+    {
+        const char* name;
+        FlangerParameters parameters; // gain, freqLFO, depthLFO, envToDepth, envToRate
+    };
+
+    const FactoryPreset factoryPresets[] =
+    {
+        { "Default",        { 0.5, 2.0,  0.5,  0.0, 0.0 } },
+        { "Slow Sweep",     { 0.5, 0.2,  0.8,  0.0, 0.0 } },
+        { "Jet",            { 0.6, 0.1,  1.0,  0.0, 0.0 } },
+        { "Subtle Shimmer", { 0.5, 0.8,  0.05, 0.0, 0.0 } },
+        { "Fast Wobble",    { 0.5, 6.0,  0.2,  0.0, 0.0 } },
+        { "Ducking Sweep",  { 0.5, 0.5,  0.2,  0.6, 0.0 } },
+        { "Follow Drums",   { 0.5, 1.0,  0.3,  0.3, 0.5 } }
+    };
+
+    // Reads a parameter from a preset file, limited to the range of its slider in the editor (files may have been edited by hand)
+    double readParameter (const juce::XmlElement& xml, const char* name, double defaultValue, double minValue, double maxValue)
+    {
+        const double value = xml.getDoubleAttribute (name, defaultValue);
+        return std::isfinite (value) ? juce::jlimit (minValue, maxValue, value) : defaultValue;
+    }
+}
+
+PresetBank::PresetBank()
+{
+    PresetList list;
+    for (auto& factoryPreset : factoryPresets)
+        list.push_back (allPresets.add (new Preset { factoryPreset.name, factoryPreset.parameters, true }));
+
+    publish (std::move (list));
+    rescanUserPresets();
+}
+
+void PresetBank::publish (PresetList newList)
+{
+    allLists.push_back (std::make_unique<const PresetList> (std::move (newList)));
+    currentList.store (allLists.back().get(), std::memory_order_release);
+}
+
+juce::File PresetBank::getUserPresetDirectory()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+               .getChildFile ("NordicSMC")
+               .getChildFile (JucePlugin_Name)
+               .getChildFile ("Presets");
+}
+
+void PresetBank::rescanUserPresets()
+{
+    const AudioThreadAudit::Mutex::ScopedLockType lock (writeLock);
+    PresetList list (getPresets());
+
+    for (auto& file : getUserPresetDirectory().findChildFiles (juce::File::findFiles, false, "*.xml"))
+    {
+        auto preset = loadPreset (file);
+        if (preset == nullptr)
+            continue;
+
+        bool isNew = true;
+        for (auto* existing : list)
+            if (! existing->isFactoryPreset && existing->name == preset->name)
+                isNew = false;
+
+        if (isNew)
+            list.push_back (allPresets.add (preset.release()));
+    }
+
+    if (list.size() != getPresets().size())
+        publish (std::move (list));
+}
+
+int PresetBank::saveUserPreset (const juce::String& name, const FlangerParameters& parameters)
+{
+    juce::XmlElement xml ("FlangerPreset");
+    xml.setAttribute ("name", name);
+    xml.setAttribute ("gain", parameters.gain);
+    xml.setAttribute ("freqLFO", parameters.freqLFO);
+    xml.setAttribute ("depthLFO", parameters.depthLFO);
+    xml.setAttribute ("envToDepth", parameters.envToDepth);
+    xml.setAttribute ("envToRate", parameters.envToRate);
+
+    auto directory = getUserPresetDirectory();
+    if (! directory.createDirectory()
+     || ! xml.writeTo (directory.getChildFile (juce::File::createLegalFileName (name) + ".xml")))
+        return -1;
+
+    const AudioThreadAudit::Mutex::ScopedLockType lock (writeLock);
+    auto* preset = allPresets.add (new Preset { name, parameters, false });
+    PresetList list (getPresets());
+
+    // Overwrite an existing user preset with the same name (in a new list, the old preset stays alive)
+    for (size_t i = 0; i < list.size(); ++i)
+    {
+        if (! list[i]->isFactoryPreset && list[i]->name == name)
+        {
+            list[i] = preset;
+            publish (std::move (list));
+            return static_cast<int> (i);
+        }
+    }
+
+    list.push_back (preset);
+    publish (std::move (list));
+    return static_cast<int> (getPresets().size()) - 1;
+}
+
+std::unique_ptr<Preset> PresetBank::loadPreset (const juce::File& file)
+{
+    auto xml = juce::XmlDocument::parse (file);
+    if (xml == nullptr || ! xml->hasTagName ("FlangerPreset"))
+        return nullptr;
+
+    auto preset = std::make_unique<Preset>();
+    preset->name = xml->getStringAttribute ("name", file.getFileNameWithoutExtension());
+    preset->parameters.gain       = readParameter (*xml, "gain", preset->parameters.gain, 0.0, 1.0);
+    preset->parameters.freqLFO    = readParameter (*xml, "freqLFO", preset->parameters.freqLFO, 0.0, 10.0);
+    preset->parameters.depthLFO   = readParameter (*xml, "depthLFO", preset->parameters.depthLFO, 0.0, 1.0);
+    preset->parameters.envToDepth = readParameter (*xml, "envToDepth", preset->parameters.envToDepth, 0.0, 1.0);
+    preset->parameters.envToRate  = readParameter (*xml, "envToRate", preset->parameters.envToRate, 0.0, 1.0);
+    return preset;
+}
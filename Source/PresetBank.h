@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+    Created: 19 Oct 2026
+
+    Factory presets (embedded in the binary) and user presets (stored on disk).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioThreadAudit.h"
+
+//==============================================================================
+/**
+    The parameters stored in a preset. These are all continuous, so the processor can morph between two sets.
+*/
+struct FlangerParameters
+{
+    double gain = 0.5;
+    double freqLFO = 2.0;
+    double depthLFO = 0.5;
+    double envToDepth = 0.0;
+    double envToRate = 0.0;
+
+    // Linear interpolation between a and b (t between 0 and 1)
+    static FlangerParameters interpolate (const FlangerParameters& a, const FlangerParameters& b, double t)
+    {
+        FlangerParameters result;
+        result.gain       = a.gain       + t * (b.gain       - a.gain);
+        result.freqLFO    = a.freqLFO    + t * (b.freqLFO    - a.freqLFO);
+        result.depthLFO   = a.depthLFO   + t * (b.depthLFO   - a.depthLFO);
+        result.envToDepth = a.envToDepth + t * (b.envToDepth - a.envToDepth);
+        result.envToRate  = a.envToRate  + t * (b.envToRate  - a.envToRate);
+        return result;
+    }
+};
+
+struct Preset
+{
+    juce::String name;
+    FlangerParameters parameters;
+    bool isFactoryPreset = false;
+};
+
+//==============================================================================
+/**
+    The factory presets come first, followed by the user presets (*.xml files in getUserPresetDirectory()).
+
+    rescanUserPresets() and saveUserPreset() can be called from any thread but the audio thread (they write files and take a lock,
+    so that two calls can't publish at the same time). They never change a list that has been
+    published: they build a new list and swap it in with an atomic pointer. Together with the presets, the old lists are kept
+    alive until the bank is deleted, so getNumPresets() and getPreset() can be called from any thread (including the audio thread)
+    without locking, and a pointer to the parameters of any preset stays valid.
+
+    A list only grows (a preset that is overwritten keeps its index), so an index that was valid stays valid. To read the size and
+    a preset from the same list, use getPresets().
+*/
+class PresetBank
+{
+public:
+    using PresetList = std::vector<const Preset*>;
+
+    PresetBank();
+
+    // The current list of presets (lock-free, see the class description)
+    const PresetList& getPresets() const { return *currentList.load (std::memory_order_acquire); };
+
+    int getNumPresets() const { return static_cast<int> (getPresets().size()); };
+    const Preset& getPreset (int index) const { return *getPresets()[static_cast<size_t> (index)]; };
+
+    // Adds the user presets that were added to the preset directory since the last scan
+    void rescanUserPresets();
+
+    // Stores the parameters as a user preset (on disk and in the bank) and returns its index or -1 if the file could not be written
+    int saveUserPreset (const juce::String& name, const FlangerParameters& parameters);
+
+    static juce::File getUserPresetDirectory();
+
+private:
+    static std::unique_ptr<Preset> loadPreset (const juce::File& file);
+
+    // Makes a list the current one (with writeLock held)
+    void publish (PresetList newList);
+
+    // Held by rescanUserPresets() and saveUserPreset(); the audio thread never takes it (checked by the audit, see AudioThreadAudit.h)
+    AudioThreadAudit::Mutex writeLock;
+
+    // Every preset and every list that has ever been published (with writeLock held, see the class description)
+    juce::OwnedArray<Preset> allPresets;
+    std::vector<std::unique_ptr<const PresetList>> allLists;
+
+    std::atomic<const PresetList*> currentList { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.cpp
+    Created: 19 Oct 2026
+
+    Spectrum analyser for the editor (shows the notches of the comb filter).
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyser.h"
+
+SpectrumAnalyser::SpectrumAnalyser() : Thread ("Spectrum analyser")
+{
+    // All memory is allocated here, so that neither the audio thread nor the worker allocates
+    fifoBuffer.resize (static_cast<size_t> (fifo.getTotalSize()));
+    history.resize (fftSize);
+    fftData.resize (fftSize);
+
+    for (auto& frame : frames)
+        frame.assign (numBins, minDb);
+
+    // Hann window, scaled so that a full-scale sine shows at 0 dB
+    window.resize (fftSize);
+    for (int i = 0; i < fftSize; ++i)
+        window[i] = static_cast<float> ((1.0 - std::cos (2.0 * double_Pi * i / fftSize)) / fftSize * 2.0);
+
+    twiddles.resize (fftSize / 2);
+    for (int i = 0; i < fftSize / 2; ++i)
+        twiddles[i] = std::polar (1.0f, static_cast<float> (-2.0 * double_Pi * i / fftSize));
+
+    bitReversed.resize (fftSize);
+    for (int i = 0; i < fftSize; ++i)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < fftOrder; ++bit)
+            reversed |= ((i >> bit) & 1) << (fftOrder - 1 - bit);
+        bitReversed[i] = reversed;
+    }
+}
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+    stop();
+}
+
+void SpectrumAnalyser::start()
+{
+    fifo.reset();
+    active = true;
+    startThread();
+}
+
+void SpectrumAnalyser::stop()
+{
+    active = false;
+    stopThread (1000);
+}
+
+void SpectrumAnalyser::pushSamples (const float* left, const float* right, int numSamples)
+{
+    if (! active.load (std::memory_order_relaxed))
+        return;
+
+    // Write what fits (prepareToWrite() never waits; the rest of the samples are dropped)
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i)
+        fifoBuffer[start1 + i] = right != nullptr ? 0.5f * (left[i] + right[i]) : left[i];
+    for (int i = 0; i < size2; ++i)
+        fifoBuffer[start2 + i] = right != nullptr ? 0.5f * (left[size1 + i] + right[size1 + i]) : left[size1 + i];
+
+    fifo.finishedWrite (size1 + size2);
+}
+
+bool SpectrumAnalyser::readFrame (std::vector<float>& magnitudes)
+{
+    if ((middleFrame.load (std::memory_order_acquire) & newFrameFlag) == 0)
+        return false;
+
+    // Swap the front frame with the (new) middle one
+    frontFrame = middleFrame.exchange (frontFrame, std::memory_order_acq_rel) & frameIndexMask;
+    magnitudes = frames[frontFrame];
+    return true;
+}
+
+void SpectrumAnalyser::run()
+{
+    while (! threadShouldExit())
+    {
+        // Move the samples from the FIFO into the history
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int block = 0; block < 2; ++block)
+        {
+            const int start = block == 0 ? start1 : start2;
+            const int size = block == 0 ? size1 : size2;
+            for (int i = 0; i < size; ++i)
+            {
+                history[historyLoc] = fifoBuffer[start + i];
+                historyLoc = (historyLoc + 1) & (fftSize - 1);
+            }
+        }
+
+        fifo.finishedRead (size1 + size2);
+        samplesSinceLastFrame += size1 + size2;
+
+        int waitMs = minFrameIntervalMs;
+        if (samplesSinceLastFrame >= hopSize)
+        {
+            samplesSinceLastFrame = 0;
+
+            const auto startTicks = Time::getHighResolutionTicks();
+            analyseFrame (frames[backFrame]);
+            const double frameMs = 1000.0 * Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+            // Publish the frame by swapping it with the middle one
+            backFrame = middleFrame.exchange (backFrame | newFrameFlag, std::memory_order_acq_rel) & frameIndexMask;
+
+            // CPU cap: (time of the frame) / (time between frames) <= maxDutyCycle
+            waitMs = jmax (minFrameIntervalMs, static_cast<int> (frameMs / maxDutyCycle));
+        }
+
+        wait (waitMs);
+    }
+}
+
+void SpectrumAnalyser::analyseFrame (std::vector<float>& magnitudes)
+{
+    // Window the history (oldest sample first)
+    for (int i = 0; i < fftSize; ++i)
+        fftData[bitReversed[i]] = window[i] * history[(historyLoc + i) & (fftSize - 1)];
+
+    fft();
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        const float power = std::norm (fftData[bin]);
+        magnitudes[bin] = power > 1.0e-10f ? jmax (minDb, 10.0f * std::log10 (power)) : minDb;
+    }
+}
+
+void SpectrumAnalyser::fft()
+{
+    // Iterative radix-2 FFT (the input has already been written in bit-reversed order)
+    for (int size = 2; size <= fftSize; size <<= 1)
+    {
+        const int half = size / 2;
+        const int twiddleStep = fftSize / size;
+
+        for (int start = 0; start < fftSize; start += size)
+        {
+            for (int k = 0; k < half; ++k)
+            {
+                const auto t = twiddles[k * twiddleStep] * fftData[start + k + half];
+                fftData[start + k + half] = fftData[start + k] - t;
+                fftData[start + k] += t;
+            }
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.h
+    Created: 19 Oct 2026
+
+    Spectrum analyser for the editor (shows the notches of the comb filter).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Spectrum analyser that does its work on a background thread, so that neither the audio thread nor the message thread does any FFTs.
+
+    The pipeline has three stages, none of which ever waits for another:
+        1. audio thread:  pushSamples() writes the (mono mix of the) output into a single-producer / single-consumer FIFO (AbstractFifo).
+                          This is wait-free: if the FIFO is full the samples are dropped.
+        2. worker thread: reads the FIFO, applies a Hann window and an FFT (in-house radix-2) every hopSize samples and writes the
+                          magnitudes (in dB) to a triple buffer.
+        3. editor:        readFrame() takes the newest frame from the triple buffer (if there is a new one) to rebuild its cached Path.
+
+    The triple buffer has three frames: one owned by the worker, one by the editor and one in the middle. Publishing and taking a frame is a
+    single atomic exchange of the middle index, so the worker never waits for the editor (and vice versa); the editor always gets the newest frame.
+
+    The CPU use of the worker is capped: it waits between frames so that the analysis takes at most maxDutyCycle of the time. The wait is
+    computed from the measured time of the last frame, so when the machine is under load (and frames take longer) the frame rate drops.
+*/
+class SpectrumAnalyser : private Thread
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    SpectrumAnalyser();
+    ~SpectrumAnalyser() override;
+
+    void prepare (double sampleRate) { fs = sampleRate; };
+    double getSampleRate() const { return fs; };
+
+    // Starts / stops the worker thread (call these from the editor). Samples are only pushed while the worker runs.
+    void start();
+    void stop();
+
+    // Audio thread: adds the mono mix of left and right (right may be nullptr) to the FIFO
+    void pushSamples (const float* left, const float* right, int numSamples);
+
+    // Editor: copies the newest frame (numBins magnitudes in dB) to "magnitudes". Returns false if there is no new frame since the last call.
+    bool readFrame (std::vector<float>& magnitudes);
+
+    static constexpr float minDb = -100.0f;
+
+private:
+    void run() override;
+    void analyseFrame (std::vector<float>& magnitudes);
+    void fft();
+
+    std::atomic<double> fs { 44100.0 };
+    std::atomic<bool> active { false };
+
+    // ==== FIFO (audio thread -> worker) ==== //
+    AbstractFifo fifo { 4 * fftSize };
+    std::vector<float> fifoBuffer;
+
+    // ==== Worker state ==== //
+    static constexpr int hopSize = fftSize / 2;
+    std::vector<float> history;     // the last fftSize samples (circular)
+    int historyLoc = 0;
+    int samplesSinceLastFrame = 0;
+
+    std::vector<float> window;
+    std::vector<std::complex<float>> fftData;
+    std::vector<std::complex<float>> twiddles;
+    std::vector<int> bitReversed;
+
+    static constexpr double maxDutyCycle = 0.02;    // at most 2% of one core
+    static constexpr int minFrameIntervalMs = 16;   // at most ~60 frames per second
+
+    // ==== Triple buffer (worker -> editor) ==== //
+    std::array<std::vector<float>, 3> frames;
+    std::atomic<int> middleFrame { 1 };   // index of the middle frame, plus newFrameFlag if it hasn't been read yet
+    int backFrame = 0;                    // owned by the worker
+    int frontFrame = 2;                   // owned by the editor
+    static constexpr int newFrameFlag = 4;
+    static constexpr int frameIndexMask = 3;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyser)
+};
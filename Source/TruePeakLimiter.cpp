@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    TruePeakLimiter.cpp
+    Created: 19 Oct 2026
+
+    Lookahead brickwall limiter with true-peak detection.
+
+  ==============================================================================
+*/
+
+#include "TruePeakLimiter.h"
+
+static double sinc (double x)
+{
+    return x == 0.0 ? 1.0 : DeterministicMath::sin (double_Pi * x) / (double_Pi * x);
+}
+
+void TruePeakLimiter::prepare (double sampleRate, int numChannels)
+{
+    fs = sampleRate;
+    setRelease (releaseMs);
+
+    // Lanczos-windowed sinc, centered between taps numTaps / 2 - 1 and numTaps / 2 and normalised to unity gain at DC
+    for (int phase = 0; phase < 3; ++phase)
+    {
+        const double t = (phase + 1) * 0.25;
+        double sum = 0.0;
+        double coefficients[numTaps];
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            const double x = t - (tap - (numTaps / 2 - 1));
+            coefficients[tap] = sinc (x) * sinc (x / (numTaps / 2));
+            sum += coefficients[tap];
+        }
+
+        for (int tap = 0; tap < numTaps; ++tap)
+            phaseCoefficients[phase][tap] = static_cast<float> (coefficients[tap] / sum);
+    }
+
+    /*
+     The gain reaches its minimum "lookahead" samples after a peak has been detected. A peak detected at time n concerns the
+     samples n - numTaps + 1 to n (the samples used for the interpolation), so the audio is delayed by numTaps - 1 more samples
+     and the minimum is held for one sample longer than that.
+     */
+    lookahead = jmax (1, roundToInt (lookaheadMs * 0.001 * fs));
+    delayLength = lookahead + numTaps - 1;
+    holdLength = delayLength + 1;
+
+    history.assign (numChannels, History {});
+    delayLines.assign (numChannels, std::vector<float> (delayLength, 0.0f));
+    dequeTime.resize (holdLength + 1);
+    dequeGain.resize (holdLength + 1);
+    averageBuffer.resize (lookahead);
+
+    reset();
+}
+
+void TruePeakLimiter::reset()
+{
+    for (auto& h : history)
+        h.fill (0.0f);
+
+    for (auto& delayLine : delayLines)
+        std::fill (delayLine.begin(), delayLine.end(), 0.0f);
+
+    delayLoc = 0;
+    dequeFront = 0;
+    dequeSize = 0;
+    time = 0;
+    releasedGain = 1.0f;
+
+    std::fill (averageBuffer.begin(), averageBuffer.end(), 1.0f);
+    averageLoc = 0;
+    averageSum = static_cast<double> (averageBuffer.size());
+}
+
+void TruePeakLimiter::setRelease (double releaseToSet)
+{
+    releaseMs = releaseToSet;
+    releaseCoeff = static_cast<float> (DeterministicMath::exp (-1000.0 / (releaseMs * fs)));
+}
+
+float TruePeakLimiter::estimateTruePeak (const History& h) const
+{
+    // Sample peak of the newest sample...
+    float peak = std::abs (h[numTaps - 1]);
+
+    // ...and the interpolated values in between the two middle samples
+    for (auto& coefficients : phaseCoefficients)
+    {
+        float interpolated = 0.0f;
+        for (int tap = 0; tap < numTaps; ++tap)
+            interpolated += coefficients[tap] * h[tap];
+
+        peak = jmax (peak, std::abs (interpolated));
+    }
+
+    return peak;
+}
+
+void TruePeakLimiter::process (float* const* channels, int numChannels, int numSamples)
+{
+    jassert (numChannels <= static_cast<int> (delayLines.size()));
+
+    const int dequeCapacity = static_cast<int> (dequeGain.size());
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // 1. True peak (linked over the channels)
+        float peak = 0.0f;
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto& h = history[channel];
+            std::copy (h.begin() + 1, h.end(), h.begin());
+            h[numTaps - 1] = channels[channel][i];
+            peak = jmax (peak, detectTruePeaks ? estimateTruePeak (h) : std::abs (h[numTaps - 1]));
+        }
+
+        // 2. Gain needed to keep the peak below the ceiling
+        const float gain = peak > ceiling ? ceiling / peak : 1.0f;
+
+        // 3. Sliding minimum: drop all gains from the back that can never be the minimum again, and the front if it has left the window
+        while (dequeSize > 0 && dequeGain[(dequeFront + dequeSize - 1) % dequeCapacity] >= gain)
+            --dequeSize;
+
+        const int back = (dequeFront + dequeSize) % dequeCapacity;
+        dequeTime[back] = time;
+        dequeGain[back] = gain;
+        ++dequeSize;
+
+        if (dequeTime[dequeFront] <= time - holdLength)
+        {
+            dequeFront = (dequeFront + 1) % dequeCapacity;
+            --dequeSize;
+        }
+
+        const float heldGain = dequeGain[dequeFront];
+
+        // 4. Release (the gain is allowed to go down immediately) and moving average
+        releasedGain = heldGain < releasedGain ? heldGain : heldGain + releaseCoeff * (releasedGain - heldGain);
+
+        averageSum += releasedGain - averageBuffer[averageLoc];
+        averageBuffer[averageLoc] = releasedGain;
+        averageLoc = (averageLoc + 1) % lookahead;
+
+        const float smoothedGain = static_cast<float> (averageSum / lookahead);
+
+        // 5. Apply the gain to the delayed signal
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto& delayLine = delayLines[channel];
+            const float delayed = delayLine[delayLoc];
+            delayLine[delayLoc] = channels[channel][i];
+            channels[channel][i] = delayed * smoothedGain;
+        }
+
+        delayLoc = (delayLoc + 1) % delayLength;
+        ++time;
+    }
+}
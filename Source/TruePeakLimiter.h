@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    TruePeakLimiter.h
+    Created: 19 Oct 2026
+
+    Lookahead brickwall limiter with true-peak detection.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DeterministicMath.h"
+
+//==============================================================================
+/**
+    Lookahead brickwall limiter (stereo linked) that keeps the true peak of its output below a ceiling.
+
+    Per sample, the limiter
+        1. estimates the true peak by interpolating the signal at 4x the sample rate (an 8-tap polyphase windowed-sinc interpolator at 1/4, 1/2 and 3/4 of a sample interval).
+           For a full-scale sine the estimate is at most 0.44 dB too low (at 0.45 fs), which is why the default ceiling is -0.5 dB,
+        2. computes the gain needed to keep that peak below the ceiling,
+        3. takes the minimum of that gain over a sliding window, using a monotonic deque so this is O(1) per sample,
+        4. lets the gain recover with the release time and smooths it with a moving average over the lookahead time, so that it ramps down (linearly) before a peak rather than jumping,
+        5. applies the gain to the input delayed by getLatencyInSamples() samples.
+
+    All memory is allocated in prepare(), so process() is real-time safe.
+*/
+class TruePeakLimiter
+{
+public:
+    TruePeakLimiter() = default;
+
+    // Allocates the buffers. Call this from prepareToPlay().
+    void prepare (double sampleRate, int numChannels);
+    void reset();
+
+    void setCeiling (double ceilingDb) { ceiling = static_cast<float> (DeterministicMath::exp (ceilingDb / 20.0 * 2.302585092994046)); }; // 10^(dB / 20)
+    void setRelease (double releaseToSet);
+    
+    /* Switches between the true-peak estimate (default) and the (cheaper) sample peak. The moving average of the gain smooths the switch.
+       With sample peaks, intersample peaks can exceed the ceiling by up to a few dB (for signals close to fs / 2).
+     */
+    void setTruePeakDetection (bool shouldDetectTruePeaks) { detectTruePeaks = shouldDetectTruePeaks; };
+
+    // Latency introduced by the lookahead (in samples)
+    int getLatencyInSamples() const { return delayLength; };
+
+    // Processes numChannels channels (at most the number passed to prepare()) in place
+    void process (float* const* channels, int numChannels, int numSamples);
+
+private:
+    static constexpr int numTaps = 8;
+    using History = std::array<float, numTaps>;
+
+    // Estimates the true peak of the signal in the middle of the history (the last numTaps input samples, oldest first)
+    float estimateTruePeak (const History& h) const;
+
+    // Interpolation filters for the fractional positions 1/4, 1/2 and 3/4
+    std::array<std::array<float, numTaps>, 3> phaseCoefficients;
+
+    double fs = 44100.0;
+    double releaseMs = 50.0;
+    static constexpr double lookaheadMs = 1.5;
+
+    float ceiling = 0.944f;     // -0.5 dBFS
+    bool detectTruePeaks = true;
+    float releaseCoeff = 0.0f;
+
+    int lookahead = 0;          // length of the moving average (in samples)
+    int holdLength = 0;         // length of the sliding minimum window (in samples)
+    int delayLength = 0;        // delay of the audio (in samples)
+
+    // ==== State ==== //
+    std::vector<History> history;               // last numTaps input samples for every channel (for the true-peak estimation)
+    std::vector<std::vector<float>> delayLines; // one delay line per channel
+    int delayLoc = 0;
+
+    // Monotonic deque of (time, gain) pairs: the gains are increasing from front to back, so the front is the minimum of the window
+    std::vector<int64_t> dequeTime;
+    std::vector<float> dequeGain;
+    int dequeFront = 0;
+    int dequeSize = 0;
+    int64_t time = 0;
+
+    float releasedGain = 1.0f;
+
+    // Moving average of the gain
+    std::vector<float> averageBuffer;
+    int averageLoc = 0;
+    double averageSum = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TruePeakLimiter)
+};
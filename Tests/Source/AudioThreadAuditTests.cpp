@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    AudioThreadAuditTests.cpp
+    Created: 19 Oct 2026
+
+    Runs processBlock() in all its modes with the audio thread audit on (see AudioThreadAudit.h)
+    and fails if it allocates or locks.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <mutex>
+#include <shared_mutex>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/AudioThreadAudit.h"
+
+class AudioThreadAuditTests : public UnitTest
+{
+public:
+    AudioThreadAuditTests() : UnitTest ("AudioThreadAudit", "NordicSMC") {}
+
+    void runTest() override
+    {
+       #if ! NORDICSMC_AUDIT_AUDIO_THREAD
+        beginTest ("Audit is enabled");
+        expect (false, "build the tests with NORDICSMC_AUDIT_AUDIO_THREAD=1 (see NordicSMC_Tests.jucer)");
+       #else
+       #if ! NORDICSMC_AUDIT_ABORT
+        // Makes sure the audit is actually hooked in, otherwise the sweep below would pass trivially
+        beginTest ("Violations are detected");
+        {
+            const int violationsBefore = AudioThreadAudit::getNumViolations();
+            AudioThreadAudit::Mutex mutex;
+            CriticalSection criticalSection;
+            std::mutex standardMutex;
+            std::shared_timed_mutex sharedMutex;
+            {
+                const AudioThreadAudit::ScopedAudioThread audioThread;
+                escapedAllocation = std::vector<float> (static_cast<size_t> (16 + getRandom().nextInt (48)));
+                const AudioThreadAudit::Mutex::ScopedLockType lock (mutex);
+                
+               #if defined (__GLIBC__)
+                // Locks that don't go through AudioThreadAudit::Mutex (caught by the replaced pthread functions)
+                const ScopedLock criticalSectionLock (criticalSection);
+                const std::lock_guard<std::mutex> standardLock (standardMutex);
+                const std::shared_lock<std::shared_timed_mutex> sharedLock (sharedMutex);
+               #endif
+            }
+            escapedAllocation = {};
+
+           #if defined (__GLIBC__)
+            // At least the allocation and the four locks
+            expectGreaterOrEqual (AudioThreadAudit::getNumViolations() - violationsBefore, 5);
+           #else
+            // At least the allocation and the lock
+            expectGreaterOrEqual (AudioThreadAudit::getNumViolations() - violationsBefore, 2);
+           #endif
+        }
+       #endif
+
+        beginTest ("processBlock() doesn't allocate or lock");
+        {
+            const int violationsBefore = AudioThreadAudit::getNumViolations();
+
+            for (bool useSidechain : { false, true })
+                runSweep (useSidechain);
+
+            expectEquals (AudioThreadAudit::getNumViolations() - violationsBefore, 0, "violations on the audio thread (see the log for the stack traces)");
+        }
+       #endif
+    }
+
+private:
+    /*
+     One processor goes through all combinations of the stereo mode, limiter, bit-exact mode and quality tier, with and without MIDI
+     (and changes the envelope follower's settings along with the limiter).
+     The settings change between blocks (as they would from the editor), so that the transitions are covered as well.
+     */
+    void runSweep (bool useSidechain)
+    {
+        const double fs = 44100.0;
+        const int blockSize = 512;
+        const int blocksPerSetting = 4;
+
+        NordicSMC_EffectAudioProcessor processor;
+        if (useSidechain)
+            processor.enableAllBuses();
+        processor.setCpuGovernor (false);
+        processor.prepareToPlay (fs, blockSize);
+        processor.setEnvToDepth (0.5);
+        processor.setEnvToRate (0.5);
+
+        const int numChannels = jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+        AudioBuffer<float> buffer (numChannels, blockSize);
+
+        // Note-on, modulation wheel and pitch wheel in the middle of the block
+        MidiBuffer midiEvents;
+        const uint8 noteOn[] = { 0x90, 60, 100 };
+        const uint8 modulationWheel[] = { 0xb0, 1, 64 };
+        const uint8 pitchWheel[] = { 0xe0, 0, 80 };
+        midiEvents.addEvent (noteOn, 3, 100);
+        midiEvents.addEvent (modulationWheel, 3, 200);
+        midiEvents.addEvent (pitchWheel, 3, 300);
+        MidiBuffer noMidi;
+
+        using StereoMode = NordicSMC_EffectAudioProcessor::StereoMode;
+        using QualityTier = NordicSMC_EffectAudioProcessor::QualityTier;
+
+        for (auto mode : { StereoMode::mono, StereoMode::linked, StereoMode::inverted, StereoMode::midSide, StereoMode::feedbackNetwork })
+        {
+            processor.setStereoMode (mode);
+
+            for (bool useLimiter : { false, true })
+            {
+                processor.setLookaheadLimiter (useLimiter);
+                processor.setEnvMode (useLimiter ? EnvelopeFollower::Mode::rms : EnvelopeFollower::Mode::peak);
+                processor.setEnvAttack (useLimiter ? 5.0 : 10.0);
+                processor.setEnvRelease (useLimiter ? 50.0 : 100.0);
+
+                for (bool useBitExact : { false, true })
+                {
+                    processor.setBitExact (useBitExact);
+
+                    for (auto tier : { QualityTier::full, QualityTier::linearInterpolation, QualityTier::controlRateLFO, QualityTier::samplePeakLimiter,
+                                       QualityTier::reducedNetwork })
+                    {
+                        processor.setFixedQualityTier (tier);
+                        processor.setFeedbackNetworkLines (2 + 2 * static_cast<int> (tier));
+
+                        for (bool useMidi : { false, true })
+                        {
+                            for (int block = 0; block < blocksPerSetting; ++block)
+                            {
+                                fillWithNoise (buffer);
+                                processor.processBlock (buffer, useMidi && block == 0 ? midiEvents : noMidi);
+                            }
+                        }
+
+                        // Selecting a preset is allowed on the audio thread as well (see setCurrentProgram())
+                        {
+                            const AudioThreadAudit::ScopedAudioThread audioThread;
+                            processor.setCurrentProgram ((static_cast<int> (tier) + 1) % processor.getNumPrograms());
+                        }
+                    }
+                }
+            }
+        }
+
+        processor.releaseResources();
+    }
+
+    void fillWithNoise (AudioBuffer<float>& buffer)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (channel, i, 2.0f * noise.nextFloat() - 1.0f);
+    }
+
+    Random noise { 1 };
+    std::vector<float> escapedAllocation; // keeps the compiler from optimising the test allocation away
+};
+
+static AudioThreadAuditTests audioThreadAuditTests;
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    BitExactTests.cpp
+    Created: 19 Oct 2026
+
+    Unit tests of the bit-exact mode: the render checksums must match the reference values on every build
+    (see DeterministicMath.h for the builds that are covered).
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+class BitExactTests : public UnitTest
+{
+public:
+    BitExactTests() : UnitTest ("BitExact", "NordicSMC") {}
+
+    void runTest() override
+    {
+        using StereoMode = NordicSMC_EffectAudioProcessor::StereoMode;
+
+        /*
+         Reference checksums of 2 seconds of renderInput() at 44.1 kHz with the default parameters.
+         If a change to the processing is intended to change the output, render these again and update them
+         (and tell the render farm, since its stored checksums change as well).
+         */
+        struct Reference
+        {
+            const char* name;
+            StereoMode mode;
+            bool useLimiter;
+            uint64_t checksum;
+        };
+
+        const Reference references[] =
+        {
+            { "mono",                     StereoMode::mono,            false, 0xadee38728a7538c5ull },
+            { "linked",                   StereoMode::linked,          false, 0xd4e38bbd159bc79cull },
+            { "inverted",                 StereoMode::inverted,        false, 0xb4242044d31bbe00ull },
+            { "midSide",                  StereoMode::midSide,         false, 0xeb9e772ed3ab1139ull },
+            { "feedbackNetwork",          StereoMode::feedbackNetwork, false, 0x9ed3613e104c6853ull },
+            { "linked, limiter",          StereoMode::linked,          true,  0xb63f490b8861d5feull }
+        };
+
+        beginTest ("Checksums match the reference renders");
+        {
+            for (auto& reference : references)
+            {
+                const auto checksum = render (reference.mode, reference.useLimiter, { 512 });
+                expect (checksum == reference.checksum, String (reference.name) + ": checksum " + String::toHexString (static_cast<int64> (checksum))
+                                                        + " instead of " + String::toHexString (static_cast<int64> (reference.checksum)));
+            }
+        }
+
+        beginTest ("Checksums don't depend on the block size");
+        {
+            for (auto& reference : references)
+                for (const auto& blockSizes : { std::vector<int> { 64 }, std::vector<int> { 1000 }, std::vector<int> { 1, 300, 17, 2048, 256 } })
+                    expect (render (reference.mode, reference.useLimiter, blockSizes) == reference.checksum, String (reference.name) + ": block size changes the output");
+        }
+    }
+
+private:
+    // Renders 2 seconds with the block sizes (cycled through) and returns the checksum
+    static uint64_t render (NordicSMC_EffectAudioProcessor::StereoMode mode, bool useLimiter, const std::vector<int>& blockSizes)
+    {
+        const double fs = 44100.0;
+        const int maxBlockSize = *std::max_element (blockSizes.begin(), blockSizes.end());
+        const int length = static_cast<int> (2.0 * fs);
+
+        NordicSMC_EffectAudioProcessor processor;
+        processor.setStereoMode (mode);
+        processor.setLookaheadLimiter (useLimiter);
+        processor.setBitExact (true);
+        processor.prepareToPlay (fs, maxBlockSize);
+
+        AudioBuffer<float> buffer (2, maxBlockSize);
+        MidiBuffer noMidi;
+
+        int start = 0;
+        for (size_t b = 0; start < length; ++b)
+        {
+            const int numSamples = jmin (blockSizes[b % blockSizes.size()], length - start);
+            buffer.setSize (2, numSamples, false, false, true);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto input = renderInput (start + i, fs);
+                buffer.setSample (0, i, input.first);
+                buffer.setSample (1, i, input.second);
+            }
+
+            processor.processBlock (buffer, noMidi);
+            start += numSamples;
+        }
+
+        processor.releaseResources();
+        return processor.getRenderChecksum();
+    }
+
+    // Test signal (computed with DeterministicMath, so that the input is identical on every build as well): two sines
+    // per channel that peak at 1.5, so that the limiter has work to do
+    static std::pair<float, float> renderInput (int n, double fs)
+    {
+        const double t = n / fs;
+        const double left = 0.9 * DeterministicMath::sin (2.0 * double_Pi * std::fmod (220.0 * t, 1.0))
+                          + 0.6 * DeterministicMath::sin (2.0 * double_Pi * std::fmod (1375.0 * t, 1.0));
+        const double right = 0.9 * DeterministicMath::sin (2.0 * double_Pi * std::fmod (330.0 * t, 1.0))
+                           + 0.6 * DeterministicMath::sin (2.0 * double_Pi * std::fmod (2750.0 * t, 1.0));
+        return { static_cast<float> (left), static_cast<float> (right) };
+    }
+};
+
+static BitExactTests bitExactTests;
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    FeedbackDelayNetworkTests.cpp
+    Created: 19 Oct 2026
+
+    Unit tests of the feedback delay network.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/FeedbackDelayNetwork.h"
+
+class FeedbackDelayNetworkTests : public UnitTest
+{
+public:
+    FeedbackDelayNetworkTests() : UnitTest ("FeedbackDelayNetwork", "NordicSMC") {}
+
+    void runTest() override
+    {
+        const double fs = 44100.0;
+        const int maxModulation = 1000;
+        
+        beginTest ("Output doesn't depend on the tile sizes");
+        {
+            std::vector<float> left (static_cast<size_t> (fs)), right (left.size());
+            fillWithNoise (left, right);
+            auto left2 = left, right2 = right;
+            
+            FeedbackDelayNetwork network;
+            network.prepare (fs, maxModulation);
+            processInTiles (network, left, right, { 256 });
+            
+            FeedbackDelayNetwork network2;
+            network2.prepare (fs, maxModulation);
+            processInTiles (network2, left2, right2, { 1, 37, 256, 100, 3, 255, 64 });
+            
+            expect (left == left2 && right == right2, "different output for different tile sizes");
+        }
+        
+        beginTest ("Halving the lines");
+        {
+            std::vector<float> left (static_cast<size_t> (fs)), right (left.size());
+            fillWithNoise (left, right);
+            auto left2 = left, right2 = right;
+            
+            // 8 lines halved run the same 4 lines as a network set to 4 lines
+            FeedbackDelayNetwork network;
+            network.prepare (fs, maxModulation);
+            network.setNumLines (8);
+            network.setHalveLines (true);
+            processInTiles (network, left, right, { 256 });
+            
+            FeedbackDelayNetwork network2;
+            network2.prepare (fs, maxModulation);
+            network2.setNumLines (4);
+            processInTiles (network2, left2, right2, { 256 });
+            
+            expect (left == left2 && right == right2, "halved network differs from one with half the lines");
+            
+            network2.setNumLines (2);
+            expect (! network2.canHalveLines(), "2 lines can't be halved");
+        }
+        
+        beginTest ("Gain starts at its current value after reset()");
+        {
+            FeedbackDelayNetwork network;
+            network.prepare (fs, maxModulation);
+            
+            // The dry part of the first sample is the input times the gain (the lines are still empty)
+            float left = 1.0f, right = 1.0f;
+            network.process (&left, &right, 1, 1.0, 0.5, 0.7);
+            expectWithinAbsoluteError (left, 0.7f, 1.0e-6f);
+        }
+        
+        beginTest ("Lines that become active are cleared");
+        {
+            FeedbackDelayNetwork network;
+            network.prepare (fs, maxModulation);
+            network.setNumLines (8);
+            
+            std::vector<float> left (static_cast<size_t> (fs)), right (left.size());
+            fillWithNoise (left, right);
+            processInTiles (network, left, right, { 256 });
+            
+            // With 2 lines, the signal in those lines decays (the other 6 still hold the noise)
+            network.setNumLines (2);
+            std::fill (left.begin(), left.end(), 0.0f);
+            std::fill (right.begin(), right.end(), 0.0f);
+            processInTiles (network, left, right, { 256 });
+            
+            network.setNumLines (8);
+            std::fill (left.begin(), left.end(), 0.0f);
+            std::fill (right.begin(), right.end(), 0.0f);
+            processInTiles (network, left, right, { 256 });
+            
+            float peak = 0.0f;
+            for (size_t i = 0; i < left.size(); ++i)
+                peak = jmax (peak, std::abs (left[i]), std::abs (right[i]));
+            expectLessThan (peak, 1.0e-6f, "stale signal from lines that were inactive");
+        }
+        
+        beginTest ("Tail length covers the decay");
+        {
+            FeedbackDelayNetwork network;
+            network.prepare (fs, maxModulation);
+            network.setFeedback (0.9f);
+            
+            // An impulse: after the reported tail the output is 60 dB down
+            std::vector<float> left (static_cast<size_t> (3.0 * fs), 0.0f), right (left.size(), 0.0f);
+            left[0] = right[0] = 1.0f;
+            processInTiles (network, left, right, { 256 });
+            
+            const auto tailEnd = static_cast<size_t> (network.getTailLengthSeconds() * fs);
+            expect (tailEnd < left.size(), "tail longer than the test signal");
+            
+            float peak = 0.0f;
+            for (size_t i = tailEnd; i < left.size(); ++i)
+                peak = jmax (peak, std::abs (left[i]), std::abs (right[i]));
+            expectLessThan (peak, 0.001f, "output above -60 dB after the tail");
+        }
+        
+        beginTest ("Throughput");
+        {
+            // The cost per line should be roughly constant, i.e. the time per sample frame close to linear in the number of lines
+            std::vector<float> left (static_cast<size_t> (10.0 * fs)), right (left.size());
+            fillWithNoise (left, right);
+            
+            for (int numLines = 2; numLines <= 8; numLines += 2)
+            {
+                FeedbackDelayNetwork network;
+                network.prepare (fs, maxModulation);
+                network.setNumLines (numLines);
+                
+                auto left2 = left, right2 = right;
+                const auto startTicks = Time::getHighResolutionTicks();
+                processInTiles (network, left2, right2, { 256 });
+                const double seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+                
+                const double nsPerSample = 1.0e9 * seconds / static_cast<double> (left.size());
+                logMessage (String (numLines) + " lines: " + String (nsPerSample) + " ns per sample frame (" + String (nsPerSample / numLines) + " ns per line)");
+            }
+        }
+    }
+
+private:
+    static void fillWithNoise (std::vector<float>& left, std::vector<float>& right)
+    {
+        Random random (1);
+        for (size_t i = 0; i < left.size(); ++i)
+        {
+            left[i] = 2.0f * random.nextFloat() - 1.0f;
+            right[i] = 2.0f * random.nextFloat() - 1.0f;
+        }
+    }
+    
+    // Processes the signal with constant parameters, cycling through the tile sizes
+    static void processInTiles (FeedbackDelayNetwork& network, std::vector<float>& left, std::vector<float>& right, const std::vector<int>& tileSizes)
+    {
+        size_t start = 0;
+        for (size_t t = 0; start < left.size(); ++t)
+        {
+            const int numSamples = jmin (tileSizes[t % tileSizes.size()], static_cast<int> (left.size() - start));
+            network.process (left.data() + start, right.data() + start, numSamples, 1.0, 0.5, 0.7);
+            start += static_cast<size_t> (numSamples);
+        }
+    }
+};
+
+static FeedbackDelayNetworkTests feedbackDelayNetworkTests;
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    FractionalDelayTests.cpp
+    Created: 19 Oct 2026
+
+    Unit tests of the read paths of the flanger (see FractionalDelay.h).
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/FractionalDelay.h"
+
+class FractionalDelayTests : public UnitTest
+{
+public:
+    FractionalDelayTests() : UnitTest ("FractionalDelay", "NordicSMC") {}
+
+    void runTest() override
+    {
+        const double fs = 44100.0;
+        const int maxDelay = 1000;
+        const auto lfoTable = FractionalDelay::makeLfoTable();
+
+        /*
+         The delay line holds a ramp (the value of every sample is its index), so that a linear read returns the read position itself.
+         The write location is at the end, so that the reads never wrap around (which would break the ramp).
+         */
+        const int delayMask = 2047;
+        const int writeLoc = delayMask;
+        std::vector<float> ramp (static_cast<size_t> (delayMask + 1));
+        for (int i = 0; i <= delayMask; ++i)
+            ramp[static_cast<size_t> (i)] = static_cast<float> (i);
+
+        beginTest ("Fixed-point delay follows the exact LFO within 1e-3 samples");
+        {
+            // A few seconds of LFO at the maximum depth (where the error is largest) and at a few lower depths
+            for (double depth : { 1.0, 0.7, 0.25, 0.01 })
+            {
+                for (double rate : { 0.1, 2.0, 13.7 })
+                {
+                    const int64_t depthQ16 = static_cast<int64_t> (depth * maxDelay * 65536.0);
+                    const uint32_t phaseInc = FractionalDelay::phaseIncrement (rate, fs);
+                    uint32_t phase = 0;
+                    double maxError = 0.0;
+
+                    for (int i = 0; i < static_cast<int> (3.0 * fs); ++i)
+                    {
+                        phase += phaseInc;
+
+                        // Exact trajectory at the (quantised) phase of the accumulator
+                        const double exactDelay = depth * maxDelay * (1.0 + std::sin (2.0 * double_Pi * phase / 4294967296.0)) * 0.5;
+
+                        const uint32_t delay = FractionalDelay::delayQ16 (FractionalDelay::lookupLfo (lfoTable, phase), depthQ16);
+                        const double readPosition = FractionalDelay::readLinear (ramp, writeLoc, delayMask, delay);
+
+                        maxError = jmax (maxError, std::abs (readPosition - (writeLoc - exactDelay)));
+                    }
+
+                    expectLessThan (maxError, 1.0e-3, "depth " + String (depth) + ", rate " + String (rate) + " Hz");
+                }
+            }
+        }
+
+        beginTest ("Floating-point read matches the fixed-point read");
+        {
+            // Same positions in both formats (exact in Q16.16), including whole samples and delays below one sample
+            for (uint32_t delay : { 0u, 1u, 0x8000u, 0x10000u, 0x18000u, 0x3e7ffffu, 0x3e80000u })
+            {
+                const float fixedPoint = FractionalDelay::readLinear (ramp, writeLoc, delayMask, delay);
+                const float floatingPoint = FractionalDelay::readLinear (ramp, writeLoc, delayMask, delay * (1.0 / 65536.0));
+                expectWithinAbsoluteError (fixedPoint, floatingPoint, 1.0e-3f);
+            }
+        }
+
+        beginTest ("Throughput");
+        {
+            // LFO plus read per sample, as in the flanger's inner loop (with random input, so that the reads aren't predictable)
+            Random random (1);
+            std::vector<float> delayLine (ramp.size());
+            for (auto& sample : delayLine)
+                sample = 2.0f * random.nextFloat() - 1.0f;
+
+            const int numSamples = static_cast<int> (10.0 * fs);
+            const double rate = 2.0;
+            const double depth = 0.5;
+
+            float sum = 0.0f;
+            auto startTicks = Time::getHighResolutionTicks();
+            {
+                const int64_t depthQ16 = static_cast<int64_t> (depth * maxDelay * 65536.0);
+                const uint32_t phaseInc = FractionalDelay::phaseIncrement (rate, fs);
+                uint32_t phase = 0;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    phase += phaseInc;
+                    const uint32_t delay = FractionalDelay::delayQ16 (FractionalDelay::lookupLfo (lfoTable, phase), depthQ16);
+                    sum += FractionalDelay::readLinear (delayLine, i & delayMask, delayMask, delay);
+                }
+            }
+            const double fixedPointSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+            startTicks = Time::getHighResolutionTicks();
+            {
+                const double phaseInc = 2.0 * double_Pi * rate / fs;
+                double phase = 0.0;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    phase += phaseInc;
+                    const double delay = maxDelay * depth * (1.0 + sin (phase)) * 0.5;
+                    sum += FractionalDelay::readLinear (delayLine, i & delayMask, delayMask, delay);
+                }
+            }
+            const double floatingPointSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+            // Uses the result, so that the compiler can't drop the loops
+            expect (std::isfinite (sum));
+
+            logMessage ("Fixed-point LFO and read: " + String (1.0e9 * fixedPointSeconds / numSamples) + " ns per sample");
+            logMessage ("Floating-point LFO and read: " + String (1.0e9 * floatingPointSeconds / numSamples) + " ns per sample");
+        }
+    }
+};
+
+static FractionalDelayTests fractionalDelayTests;
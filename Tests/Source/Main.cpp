@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 19 Oct 2026
+
+    Console application that runs the unit tests of the plugin (category "NordicSMC").
+    Open Tests/NordicSMC_Tests.jucer in the Projucer, export it and run the resulting binary;
+    it returns a non-zero exit code if any test fails, so it can be used in automated builds.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+int main (int argc, char* argv[])
+{
+    ignoreUnused (argc, argv);
+    
+    UnitTestRunner runner;
+    runner.setAssertOnFailure (false);
+    runner.runTestsInCategory ("NordicSMC");
+    
+    int numFailures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult (i)->failures;
+    
+    return numFailures > 0 ? 1 : 0;
+}
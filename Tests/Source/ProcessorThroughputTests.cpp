@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    ProcessorThroughputTests.cpp
+    Created: 19 Oct 2026
+
+    Throughput measurements of the processor and its stages. These only log their results (timings depend on the machine),
+    so run the tests in a release build and compare the numbers in the log.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+class ProcessorThroughputTests : public UnitTest
+{
+public:
+    ProcessorThroughputTests() : UnitTest ("ProcessorThroughput", "NordicSMC") {}
+
+    void runTest() override
+    {
+        beginTest ("Sanity guard");
+        {
+            using Processor = NordicSMC_EffectAudioProcessor;
+            const float denormal = std::numeric_limits<float>::denorm_min();
+            const float infinity = std::numeric_limits<float>::infinity();
+            const float nan = std::numeric_limits<float>::quiet_NaN();
+            const float maximum = std::numeric_limits<float>::max();
+            const float minimum = std::numeric_limits<float>::min();
+
+            // The bit tricks in scanBlock() have to classify the edge cases like std::isfinite() and std::fpclassify()
+            const float clean[] = { 0.0f, -0.0f, 1.0f, -1.0f, minimum, -minimum, maximum, -maximum };
+            const float denormals[] = { 1.0f, denormal, -denormal, minimum * 0.5f };
+            const float nonFinite[] = { 1.0f, infinity, -infinity, nan, -nan };
+            expectEquals (Processor::scanBlock (clean, 8), static_cast<int> (Processor::blockIsClean));
+            for (int i = 1; i < 4; ++i)
+                expectEquals (Processor::scanBlock (denormals, 1) | Processor::scanBlock (denormals + i, 1), static_cast<int> (Processor::blockHasDenormals));
+            for (int i = 1; i < 5; ++i)
+            {
+                expectEquals (Processor::scanBlock (nonFinite + i, 1), static_cast<int> (Processor::blockHasNonFinite));
+                expect (Processor::containsNonFinite (nonFinite, i + 1));
+            }
+            expect (! Processor::containsNonFinite (clean, 8));
+            expect (! Processor::containsNonFinite (denormals, 4));
+
+            // The guard scans every channel of a tile twice (input and output), so compare both scans per sample frame with processBlock()
+            const int numSamples = 256;
+            AudioBuffer<float> tile (2, numSamples);
+            fillWithNoise (tile);
+
+            const int numRepeats = static_cast<int> (seconds * fs) / numSamples;
+            int flags = 0;
+            const auto startTicks = Time::getHighResolutionTicks();
+            for (int repeat = 0; repeat < numRepeats; ++repeat)
+            {
+                for (int channel = 0; channel < 2; ++channel)
+                    flags |= Processor::scanBlock (tile.getReadPointer (channel), numSamples);
+
+                for (int channel = 0; channel < 2; ++channel)
+                    if (Processor::containsNonFinite (tile.getReadPointer (channel), numSamples))
+                        flags |= Processor::blockHasNonFinite;
+            }
+            const double guardNs = 1.0e9 * Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks) / (numRepeats * numSamples);
+            expectEquals (flags, static_cast<int> (Processor::blockIsClean));
+
+            Processor processor;
+            processor.setStereoMode (Processor::StereoMode::linked);
+            const double processNs = measureProcessBlock (processor, 512);
+
+            logMessage ("Sanity guard (stereo): " + String (guardNs, 3) + " ns per sample frame, " + String (100.0 * guardNs / processNs, 2)
+                        + "% of processBlock() (" + String (processNs, 2) + " ns per sample frame, linked stereo)");
+        }
+
+        beginTest ("Block sizes");
+        {
+            // Large blocks are split into tiles internally, so the time per sample frame should stay flat from 64 up to 65536 samples
+            for (int blockSize = 64; blockSize <= 65536; blockSize *= 2)
+            {
+                NordicSMC_EffectAudioProcessor processor;
+                processor.setStereoMode (NordicSMC_EffectAudioProcessor::StereoMode::linked);
+                logMessage ("Block size " + String (blockSize) + ": " + String (measureProcessBlock (processor, blockSize), 2) + " ns per sample frame (linked stereo)");
+            }
+        }
+
+        beginTest ("Sidechain");
+        {
+            // Envelope follower on its own, per sample frame of a stereo sidechain in tiles of 256 samples (as in processTile())
+            const int numSamples = 256;
+            AudioBuffer<float> sidechain (2, numSamples);
+            fillWithNoise (sidechain);
+            std::vector<float> envelope (static_cast<size_t> (numSamples));
+            const int numRepeats = static_cast<int> (seconds * fs) / numSamples;
+
+            for (auto mode : { EnvelopeFollower::Mode::peak, EnvelopeFollower::Mode::rms })
+            {
+                EnvelopeFollower follower;
+                follower.prepare (fs);
+                follower.setMode (mode);
+
+                float sum = 0.0f;
+                const auto startTicks = Time::getHighResolutionTicks();
+                for (int repeat = 0; repeat < numRepeats; ++repeat)
+                {
+                    follower.process (sidechain.getArrayOfReadPointers(), 2, envelope.data(), numSamples);
+                    sum += envelope.back();
+                }
+                const double followerNs = 1.0e9 * Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks) / (numRepeats * numSamples);
+                expect (std::isfinite (sum));
+
+                logMessage (String (mode == EnvelopeFollower::Mode::peak ? "Envelope follower (peak): " : "Envelope follower (RMS): ")
+                            + String (followerNs, 3) + " ns per sample frame (stereo sidechain)");
+            }
+
+            // processBlock() with the sidechain bus disabled and enabled (the envelope modulates the depth and rate)
+            for (bool useSidechain : { false, true })
+            {
+                NordicSMC_EffectAudioProcessor processor;
+                if (useSidechain)
+                    processor.enableAllBuses();
+                processor.setStereoMode (NordicSMC_EffectAudioProcessor::StereoMode::linked);
+                processor.setEnvToDepth (0.5);
+                processor.setEnvToRate (0.5);
+
+                logMessage (String (useSidechain ? "Sidechain enabled: " : "Sidechain disabled: ") + String (measureProcessBlock (processor, 512), 2)
+                            + " ns per sample frame (linked stereo)");
+            }
+        }
+
+        beginTest ("Bit-exact mode");
+        {
+            // The bit-exact mode uses the table-based LFO and computes a checksum of the output (see BitExactTests.cpp)
+            using StereoMode = NordicSMC_EffectAudioProcessor::StereoMode;
+
+            for (auto mode : { StereoMode::mono, StereoMode::linked, StereoMode::feedbackNetwork })
+            {
+                const String modeName = mode == StereoMode::mono ? "mono" : (mode == StereoMode::linked ? "linked stereo" : "feedback network");
+
+                for (bool useBitExact : { false, true })
+                {
+                    NordicSMC_EffectAudioProcessor processor;
+                    processor.setStereoMode (mode);
+                    processor.setBitExact (useBitExact);
+
+                    logMessage (String (useBitExact ? "Bit-exact mode (" : "Default mode (") + modeName + "): "
+                                + String (measureProcessBlock (processor, 512), 2) + " ns per sample frame");
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr double fs = 44100.0;
+    static constexpr double seconds = 2.0;  // length of the audio processed per measurement
+
+    /*
+     Prepares the processor and runs processBlock() on seconds of stereo noise in blocks of blockSize samples.
+     Returns the time per sample frame in nanoseconds (including a copy of the input into the buffer before every block).
+     */
+    double measureProcessBlock (NordicSMC_EffectAudioProcessor& processor, int blockSize)
+    {
+        processor.setCpuGovernor (false);
+        processor.prepareToPlay (fs, blockSize);
+
+        const int numChannels = jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+        AudioBuffer<float> input (numChannels, blockSize), buffer (numChannels, blockSize);
+        fillWithNoise (input);
+        MidiBuffer noMidi;
+
+        const int numBlocks = jmax (2, static_cast<int> (seconds * fs) / blockSize);
+        const auto startTicks = Time::getHighResolutionTicks();
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                FloatVectorOperations::copy (buffer.getWritePointer (channel), input.getReadPointer (channel), blockSize);
+
+            processor.processBlock (buffer, noMidi);
+        }
+        const double elapsed = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+        processor.releaseResources();
+        return 1.0e9 * elapsed / (static_cast<double> (numBlocks) * blockSize);
+    }
+
+    void fillWithNoise (AudioBuffer<float>& buffer)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (channel, i, 2.0f * noise.nextFloat() - 1.0f);
+    }
+
+    Random noise { 1 };
+};
+
+static ProcessorThroughputTests processorThroughputTests;
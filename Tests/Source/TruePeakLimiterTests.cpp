@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    TruePeakLimiterTests.cpp
+    Created: 19 Oct 2026
+
+    Unit tests of the lookahead true-peak limiter.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/TruePeakLimiter.h"
+
+class TruePeakLimiterTests : public UnitTest
+{
+public:
+    TruePeakLimiterTests() : UnitTest ("TruePeakLimiter", "NordicSMC") {}
+
+    void runTest() override
+    {
+        const double fs = 44100.0;
+        const float ceiling = static_cast<float> (std::pow (10.0, -0.5 / 20.0)); // the default ceiling of -0.5 dBFS
+        
+        beginTest ("Near-Nyquist sine stays below the ceiling");
+        {
+            // A 0.45 fs sine 5 dB above full scale: its sample peaks vary with the phase, so this needs the true-peak detection
+            TruePeakLimiter limiter;
+            limiter.prepare (fs, 2);
+            
+            std::vector<float> left (static_cast<size_t> (fs)), right (left.size());
+            for (size_t i = 0; i < left.size(); ++i)
+                left[i] = right[i] = 1.8f * static_cast<float> (std::sin (2.0 * double_Pi * 0.45 * static_cast<double> (i)));
+            
+            processInBlocks (limiter, left, right, 512);
+            
+            // After the lookahead, the output never exceeds the ceiling
+            float peak = 0.0f;
+            for (size_t i = static_cast<size_t> (limiter.getLatencyInSamples()); i < left.size(); ++i)
+                peak = jmax (peak, std::abs (left[i]), std::abs (right[i]));
+            
+            expectLessOrEqual (peak, ceiling * 1.0001f, "output peak above the ceiling");
+            expectGreaterThan (peak, 0.5f * ceiling, "the limiter should not simply mute the signal");
+            
+            // The true peak may be up to 0.44 dB above the ceiling (see TruePeakLimiter.h), but there must be no overs
+            expectLessOrEqual (measureTruePeak (left, limiter.getLatencyInSamples() + 64), 1.0f, "intersample peak above 0 dBFS");
+        }
+        
+        beginTest ("Intersample peaks are detected");
+        {
+            // fs / 4 sine with a phase of 45 degrees: all samples are at 1 / sqrt (2) of the amplitude (0.92 here, below the ceiling),
+            // so only the true-peak detection sees that the signal itself peaks at 1.3 in between the samples
+            TruePeakLimiter limiter;
+            limiter.prepare (fs, 2);
+            
+            std::vector<float> left (static_cast<size_t> (fs / 4)), right (left.size());
+            for (size_t i = 0; i < left.size(); ++i)
+                left[i] = right[i] = 1.3f * static_cast<float> (std::sin (0.5 * double_Pi * static_cast<double> (i) + 0.25 * double_Pi));
+            
+            processInBlocks (limiter, left, right, 512);
+            
+            expectLessOrEqual (measureTruePeak (left, limiter.getLatencyInSamples() + 64), 1.0f, "intersample peak above 0 dBFS");
+        }
+        
+        beginTest ("Reported latency matches the actual delay");
+        {
+            TruePeakLimiter limiter;
+            limiter.prepare (fs, 2);
+            
+            // An impulse below the ceiling passes unchanged, delayed by the latency
+            const int impulseTime = 100;
+            std::vector<float> left (2048, 0.0f), right (2048, 0.0f);
+            left[impulseTime] = right[impulseTime] = 0.5f;
+            
+            processInBlocks (limiter, left, right, 64);
+            
+            const auto maxPosition = std::max_element (left.begin(), left.end(), [] (float a, float b) { return std::abs (a) < std::abs (b); }) - left.begin();
+            expectEquals (static_cast<int> (maxPosition), impulseTime + limiter.getLatencyInSamples());
+            expectWithinAbsoluteError (left[static_cast<size_t> (maxPosition)], 0.5f, 1.0e-6f);
+        }
+        
+        beginTest ("Throughput");
+        {
+            TruePeakLimiter limiter;
+            limiter.prepare (fs, 2);
+            
+            Random random (1);
+            std::vector<float> left (static_cast<size_t> (10.0 * fs)), right (left.size());
+            for (size_t i = 0; i < left.size(); ++i)
+            {
+                left[i] = 2.0f * random.nextFloat() - 1.0f;
+                right[i] = 2.0f * random.nextFloat() - 1.0f;
+            }
+            
+            const auto startTicks = Time::getHighResolutionTicks();
+            processInBlocks (limiter, left, right, 512);
+            const double seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+            
+            logMessage ("Stereo true-peak limiter: " + String (1.0e9 * seconds / static_cast<double> (left.size())) + " ns per sample frame ("
+                        + String (10.0 / seconds) + "x real time at 44.1 kHz)");
+        }
+    }
+
+private:
+    // Reference true-peak meter: 8x oversampling with a long (64-tap) Hann-windowed sinc
+    static float measureTruePeak (const std::vector<float>& x, int start)
+    {
+        const int halfLength = 32;
+        const int oversampling = 8;
+        float peak = 0.0f;
+        
+        for (int i = start; i < static_cast<int> (x.size()) - halfLength; ++i)
+        {
+            for (int phase = 0; phase < oversampling; ++phase)
+            {
+                const double t = static_cast<double> (phase) / oversampling;
+                double sum = 0.0;
+                for (int k = -halfLength + 1; k <= halfLength; ++k)
+                {
+                    const double d = k - t;
+                    const double sinc = d == 0.0 ? 1.0 : std::sin (double_Pi * d) / (double_Pi * d);
+                    const double window = 0.5 + 0.5 * std::cos (double_Pi * d / halfLength);
+                    sum += x[static_cast<size_t> (i + k)] * sinc * window;
+                }
+                peak = jmax (peak, static_cast<float> (std::abs (sum)));
+            }
+        }
+        
+        return peak;
+    }
+    
+    static void processInBlocks (TruePeakLimiter& limiter, std::vector<float>& left, std::vector<float>& right, int blockSize)
+    {
+        for (size_t start = 0; start < left.size(); start += static_cast<size_t> (blockSize))
+        {
+            float* channels[] = { left.data() + start, right.data() + start };
+            limiter.process (channels, 2, jmin (blockSize, static_cast<int> (left.size() - start)));
+        }
+    }
+};
+
+static TruePeakLimiterTests truePeakLimiterTests;